@@ -1,10 +1,12 @@
 #version 450 core
 
+in vec2 uv;
+
 out vec4 colour;
 
-uniform sampler2D tex;
+layout(binding = 0) uniform sampler2D tex;
 
 void main()
 {
-    colour = texture(tex, gl_PointCoord);
+    colour = texture(tex, uv);
 }
@@ -0,0 +1,13 @@
+#version 330 core
+
+in vec2 uv;
+
+out vec4 colour;
+
+// Set to kLogoTextureUnit with glUniform1i(); 3.3 has no binding qualifier.
+uniform sampler2D tex;
+
+void main()
+{
+    colour = texture(tex, uv);
+}
@@ -0,0 +1,27 @@
+#version 330 core
+
+// vert.glsl for GL 3.3, which has no storage buffers: each logo's position
+// comes in as a per-instance attribute, read from the feedback backend's
+// {pos, velocity} buffer.
+layout(location = 0) in vec2 logoPos;
+
+uniform mat4 model;
+uniform vec2 size;
+
+// Bound to kCameraBinding with glUniformBlockBinding().
+layout(std140) uniform Camera {
+	mat4 view;
+	mat4 projection;
+};
+
+out vec2 uv;
+
+void main()
+{
+	// Triangle strip corners (0,0) (1,0) (0,1) (1,1).
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+	uv = corner;
+
+	vec2 pos = logoPos + (corner - 0.5) * size;
+	gl_Position = projection * view * model * vec4(pos, 0, 1);
+}
@@ -0,0 +1,28 @@
+#version 310 es
+
+precision mediump float;
+#ifdef TEXTURE_ARRAY
+precision mediump sampler2DArray;
+#endif
+
+in vec4 tint;
+// Atlas pages are up to 4096 texels across, beyond mediump's precision.
+in highp vec2 uv;
+flat in float layer;
+
+out vec4 colour;
+
+#ifdef TEXTURE_ARRAY
+layout(binding = 0) uniform sampler2DArray tex;
+#else
+layout(binding = 0) uniform sampler2D tex;
+#endif
+
+void main()
+{
+#ifdef TEXTURE_ARRAY
+	colour = texture(tex, vec3(uv, layer)) * tint;
+#else
+	colour = texture(tex, uv) * tint;
+#endif
+}
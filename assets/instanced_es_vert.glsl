@@ -0,0 +1,28 @@
+#version 310 es
+
+// instanced_vert.glsl for GLES 3.1, where vertex shaders need not have
+// storage buffers: each instance arrives as per-instance attributes.
+layout(location = 0) in vec4 rect;    // centre x, y, width, height in pixels
+layout(location = 1) in vec4 uvRect;    // u0, v0, u1, v1
+layout(location = 2) in float instanceLayer;
+layout(location = 3) in vec4 instanceTint;    // RGBA8, normalized
+
+layout(std140, binding = 0) uniform Camera {
+	mat4 view;
+	mat4 projection;
+};
+
+out vec4 tint;
+out vec2 uv;
+flat out float layer;
+
+void main()
+{
+	// Triangle strip corners (0,0) (1,0) (0,1) (1,1).
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+
+	tint = instanceTint;
+	uv = mix(uvRect.xy, uvRect.zw, corner);
+	layer = instanceLayer;
+	gl_Position = projection * view * vec4(rect.xy + (corner - 0.5) * rect.zw, 0, 1);
+}
@@ -0,0 +1,28 @@
+#version 450 core
+#ifdef BINDLESS
+#extension GL_ARB_bindless_texture : require
+#endif
+
+in vec4 tint;
+in vec2 uv;
+flat in float layer;
+flat in uvec2 handle;
+
+out vec4 colour;
+
+#if defined(TEXTURE_ARRAY)
+layout(binding = 0) uniform sampler2DArray tex;
+#elif !defined(BINDLESS)
+layout(binding = 0) uniform sampler2D tex;
+#endif
+
+void main()
+{
+#if defined(BINDLESS)
+	colour = texture(sampler2D(handle), uv) * tint;
+#elif defined(TEXTURE_ARRAY)
+	colour = texture(tex, vec3(uv, layer)) * tint;
+#else
+	colour = texture(tex, uv) * tint;
+#endif
+}
@@ -0,0 +1,42 @@
+#version 450 core
+#ifdef BINDLESS
+#extension GL_ARB_bindless_texture : require
+#endif
+
+struct Instance {
+	vec4 rect;    // centre x, y, width, height in pixels
+	vec4 uv;    // u0, v0, u1, v1
+	float layer;
+	uint tint;    // RGBA8, red in the lowest byte
+	uvec2 handle;
+};
+
+layout(std430, binding = 0) readonly buffer Instances {
+	Instance instances[];
+};
+
+layout(std140, binding = 0) uniform Camera {
+	mat4 view;
+	mat4 projection;
+};
+// Index of this draw's first instance in the buffer.
+layout(location = 0) uniform uint instanceBase;
+
+out vec4 tint;
+out vec2 uv;
+flat out float layer;
+flat out uvec2 handle;
+
+void main()
+{
+	Instance instance = instances[instanceBase + uint(gl_InstanceID)];
+
+	// Triangle strip corners (0,0) (1,0) (0,1) (1,1).
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+
+	tint = unpackUnorm4x8(instance.tint);
+	uv = mix(instance.uv.xy, instance.uv.zw, corner);
+	layer = instance.layer;
+	handle = instance.handle;
+	gl_Position = projection * view * vec4(instance.rect.xy + (corner - 0.5) * instance.rect.zw, 0, 1);
+}
@@ -0,0 +1,32 @@
+#version 330 core
+
+layout(location = 0) in vec2 pos;
+layout(location = 1) in vec2 velocity;
+
+out vec2 outPos;
+out vec2 outVelocity;
+// Captured only when FeedbackSim feeds trails.
+out vec2 outTrail;
+
+uniform vec4 bounds;    // minX, maxX, minY, maxY
+uniform float speed;
+
+// Transform feedback version of stepLogos() in logos.cpp.
+void main()
+{
+	vec2 p = pos + velocity * speed;
+	vec2 v = velocity;
+
+	if (p.x >= bounds.y)
+		v.x = -abs(v.x);
+	if (p.x <= bounds.x)
+		v.x = abs(v.x);
+	if (p.y >= bounds.w)
+		v.y = -abs(v.y);
+	if (p.y <= bounds.z)
+		v.y = abs(v.y);
+
+	outPos = p;
+	outVelocity = v;
+	outTrail = p;
+}
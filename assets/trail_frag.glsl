@@ -0,0 +1,14 @@
+#version 450 core
+
+in float fade;
+in vec2 uv;
+
+out vec4 colour;
+
+layout(binding = 0) uniform sampler2D tex;
+
+void main()
+{
+	// Premultiplied, so colour fades along with alpha.
+	colour = texture(tex, uv) * fade;
+}
@@ -0,0 +1,32 @@
+#version 450 core
+
+// Trail slots laid out [slot][logo].
+layout(std430, binding = 0) readonly buffer Trail {
+	vec2 trail[];
+};
+
+layout(std140, binding = 0) uniform Camera {
+	mat4 view;
+	mat4 projection;
+};
+uniform int head;
+uniform int trailLength;
+uniform int logoCount;
+uniform vec2 size;
+
+out float fade;
+out vec2 uv;
+
+void main()
+{
+	// One instance per trail sample; older slots fade out.
+	int slot = gl_InstanceID / logoCount;
+	int age = (head - slot + trailLength) % trailLength;
+	fade = 0.5 * (1.0 - float(age + 1) / float(trailLength + 1));
+
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+	uv = corner;
+
+	vec2 pos = trail[gl_InstanceID] + (corner - 0.5) * size;
+	gl_Position = projection * view * vec4(pos, 0, 1);
+}
@@ -1,12 +1,27 @@
 #version 450 core
 
-layout(location = 0) in vec2 pos;
+// One vec4 per logo with the position in xy; the feedback backend's buffer
+// keeps its velocity in zw.
+layout(std430, binding = 0) readonly buffer Logos {
+	vec4 logos[];
+};
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform vec2 size;
+
+layout(std140, binding = 0) uniform Camera {
+	mat4 view;
+	mat4 projection;
+};
+
+out vec2 uv;
 
 void main()
 {
+	// Triangle strip corners (0,0) (1,0) (0,1) (1,1).
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+	uv = corner;
+
+	vec2 pos = logos[gl_InstanceID].xy + (corner - 0.5) * size;
 	gl_Position = projection * view * model * vec4(pos, 0, 1);
 }
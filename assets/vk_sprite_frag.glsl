@@ -0,0 +1,15 @@
+#version 450
+
+layout(location = 0) in vec4 tint;
+layout(location = 1) in vec2 uv;
+layout(location = 2) flat in float layer;
+
+layout(location = 0) out vec4 colour;
+
+// One atlas page per layer.
+layout(set = 0, binding = 0) uniform sampler2DArray tex;
+
+void main()
+{
+	colour = texture(tex, vec3(uv, layer)) * tint;
+}
@@ -0,0 +1,29 @@
+#version 450
+
+// The instanced_vert.glsl quad for Vulkan, with the instance read from
+// per-instance vertex attributes rather than a storage buffer.
+layout(location = 0) in vec4 rect;    // centre x, y, width, height in pixels
+layout(location = 1) in vec4 uvRect;    // u0, v0, u1, v1
+layout(location = 2) in float instanceLayer;
+layout(location = 3) in vec4 instanceTint;
+
+// Pixel size of the arena; pixels run top-down as Vulkan's clip space does.
+layout(push_constant) uniform Arena {
+	vec2 size;
+} arena;
+
+layout(location = 0) out vec4 tint;
+layout(location = 1) out vec2 uv;
+layout(location = 2) flat out float layer;
+
+void main()
+{
+	// Triangle strip corners (0,0) (1,0) (0,1) (1,1).
+	vec2 corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1);
+
+	tint = instanceTint;
+	uv = mix(uvRect.xy, uvRect.zw, corner);
+	layer = instanceLayer;
+	vec2 position = rect.xy + (corner - 0.5) * rect.zw;
+	gl_Position = vec4(position / arena.size * 2.0 - 1.0, 0, 1);
+}
@@ -0,0 +1,251 @@
+#include "atlas.h"
+
+#include "mipmap.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+struct SkylineNode {
+    int x;
+    int y;
+    int width;
+};
+
+class SkylinePacker {
+public:
+    explicit SkylinePacker(int size)
+        : mSize(size)
+        , mSkyline {{0, 0, size}}
+    {
+    }
+
+    bool pack(int width, int height, int &outX, int &outY)
+    {
+        int bestIndex = -1;
+        int bestY = std::numeric_limits<int>::max();
+        int bestWaste = std::numeric_limits<int>::max();
+
+        for (std::size_t i = 0; i < mSkyline.size(); i++) {
+            int y = 0;
+            int waste = 0;
+            if (!fits(i, width, height, y, waste))
+                continue;
+            if (y < bestY || (y == bestY && waste < bestWaste)) {
+                bestIndex = static_cast<int>(i);
+                bestY = y;
+                bestWaste = waste;
+            }
+        }
+
+        if (bestIndex < 0)
+            return false;
+
+        outX = mSkyline[static_cast<std::size_t>(bestIndex)].x;
+        outY = bestY;
+        place(static_cast<std::size_t>(bestIndex), outX, outY, width, height);
+        return true;
+    }
+
+private:
+    /* Lowest y a rect starting at node `index` can sit at, and the area it
+     * would leave unusable underneath. */
+    bool fits(std::size_t index, int width, int height, int &y, int &waste) const
+    {
+        const int x = mSkyline[index].x;
+        if (x + width > mSize)
+            return false;
+
+        y = 0;
+        int remaining = width;
+        for (std::size_t i = index; remaining > 0; i++) {
+            if (i == mSkyline.size())
+                return false;
+            y = std::max(y, mSkyline[i].y);
+            remaining -= mSkyline[i].width;
+        }
+        if (y + height > mSize)
+            return false;
+
+        waste = 0;
+        remaining = width;
+        for (std::size_t i = index; remaining > 0; i++) {
+            int span = std::min(remaining, mSkyline[i].width);
+            waste += span * (y - mSkyline[i].y);
+            remaining -= span;
+        }
+        return true;
+    }
+
+    void place(std::size_t index, int x, int y, int width, int height)
+    {
+        mSkyline.insert(mSkyline.begin() + static_cast<std::ptrdiff_t>(index), {x, y + height, width});
+
+        // Trim the nodes now covered by the new one.
+        for (std::size_t i = index + 1; i < mSkyline.size();) {
+            SkylineNode &node = mSkyline[i];
+            const int coveredTo = x + width;
+            if (node.x >= coveredTo)
+                break;
+            const int overlap = coveredTo - node.x;
+            if (overlap >= node.width) {
+                mSkyline.erase(mSkyline.begin() + static_cast<std::ptrdiff_t>(i));
+                continue;
+            }
+            node.x += overlap;
+            node.width -= overlap;
+            break;
+        }
+
+        for (std::size_t i = 0; i + 1 < mSkyline.size();) {
+            if (mSkyline[i].y == mSkyline[i + 1].y) {
+                mSkyline[i].width += mSkyline[i + 1].width;
+                mSkyline.erase(mSkyline.begin() + static_cast<std::ptrdiff_t>(i + 1));
+            }
+            else {
+                i++;
+            }
+        }
+    }
+
+    int mSize;
+    std::vector<SkylineNode> mSkyline;
+};
+
+/* Copies `image` to (x, y) in `page`, replicating its edge pixels outwards
+ * by `padding`. (x, y) is the corner of the padded rect. */
+void blitPadded(Image &page, const Image &image, int x, int y, int padding)
+{
+    const int paddedWidth = image.width + padding * 2;
+    const int paddedHeight = image.height + padding * 2;
+
+    for (int row = 0; row < paddedHeight; row++) {
+        const int srcRow = std::max(0, std::min(row - padding, image.height - 1));
+        const unsigned char *src = &image.pixels[static_cast<std::size_t>(srcRow) * image.width * 4];
+        unsigned char *dst = &page.pixels[(static_cast<std::size_t>(y + row) * page.width + x) * 4];
+
+        for (int col = 0; col < padding; col++)
+            std::memcpy(dst + col * 4, src, 4);
+        std::memcpy(dst + padding * 4, src, static_cast<std::size_t>(image.width) * 4);
+        for (int col = padding + image.width; col < paddedWidth; col++)
+            std::memcpy(dst + col * 4, src + (image.width - 1) * 4, 4);
+    }
+}
+
+/* Top-left corner of an image's padded rect, and its page. */
+struct Placement {
+    std::size_t page;
+    int x;
+    int y;
+};
+
+/* Packs the images in order onto pages of pageSize, opening pages as needed; returns how many. */
+std::size_t placeImages(const std::vector<Image> &images, const std::vector<std::size_t> &order, int pageSize, int padding, std::vector<Placement> &placements)
+{
+    std::vector<SkylinePacker> packers;
+    for (std::size_t index : order) {
+        const int paddedWidth = images[index].width + padding * 2;
+        const int paddedHeight = images[index].height + padding * 2;
+
+        Placement &placement = placements[index];
+        placement.page = 0;
+        while (placement.page < packers.size() && !packers[placement.page].pack(paddedWidth, paddedHeight, placement.x, placement.y))
+            placement.page++;
+
+        if (placement.page == packers.size()) {
+            packers.emplace_back(pageSize);
+            packers.back().pack(paddedWidth, paddedHeight, placement.x, placement.y);
+        }
+    }
+    return packers.size();
+}
+
+} // namespace
+
+Atlas packAtlas(const std::vector<Image> &images, int maxPageSize, int padding)
+{
+    Atlas atlas;
+    atlas.padding = padding;
+    atlas.entries.resize(images.size());
+
+    std::vector<std::size_t> order(images.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return images[a].height > images[b].height;
+    });
+
+    // No page can be smaller than the largest image or the total area.
+    std::size_t area = 0;
+    int pageSize = 1;
+    for (const Image &image : images) {
+        const int paddedWidth = image.width + padding * 2;
+        const int paddedHeight = image.height + padding * 2;
+        if (paddedWidth > maxPageSize || paddedHeight > maxPageSize)
+            throw std::runtime_error("Image of " + std::to_string(image.width) + "x" + std::to_string(image.height) + " does not fit in a " + std::to_string(maxPageSize) + " atlas page.");
+        area += static_cast<std::size_t>(paddedWidth) * paddedHeight;
+        while (pageSize < std::max(paddedWidth, paddedHeight))
+            pageSize *= 2;
+    }
+    while (static_cast<std::size_t>(pageSize) * pageSize < area && pageSize < maxPageSize)
+        pageSize *= 2;
+    pageSize = std::min(pageSize, maxPageSize);
+
+    // Grow until everything fits on one page; past maxPageSize, open more.
+    std::vector<Placement> placements(images.size());
+    std::size_t pageCount = placeImages(images, order, pageSize, padding, placements);
+    while (pageCount > 1 && pageSize < maxPageSize) {
+        pageSize = std::min(pageSize * 2, maxPageSize);
+        pageCount = placeImages(images, order, pageSize, padding, placements);
+    }
+
+    atlas.pageSize = pageSize;
+    atlas.pages.resize(pageCount);
+    for (Image &page : atlas.pages) {
+        page.width = pageSize;
+        page.height = pageSize;
+        page.pixels.assign(static_cast<std::size_t>(pageSize) * pageSize * 4, 0);
+    }
+
+    const float invSize = 1.0f / static_cast<float>(pageSize);
+    for (std::size_t index = 0; index < images.size(); index++) {
+        const Image &image = images[index];
+        const Placement &placement = placements[index];
+        blitPadded(atlas.pages[placement.page], image, placement.x, placement.y, padding);
+
+        AtlasEntry &entry = atlas.entries[index];
+        entry.page = static_cast<int>(placement.page);
+        entry.width = image.width;
+        entry.height = image.height;
+        entry.u0 = static_cast<float>(placement.x + padding) * invSize;
+        entry.v0 = static_cast<float>(placement.y + padding) * invSize;
+        entry.u1 = static_cast<float>(placement.x + padding + image.width) * invSize;
+        entry.v1 = static_cast<float>(placement.y + padding + image.height) * invSize;
+    }
+
+    return atlas;
+}
+
+int atlasMipLevels(const Atlas &atlas)
+{
+    // Entries sit at arbitrary offsets, so level n sees roughly padding >> n
+    // pixels of gutter; keep at least two so bilinear taps and the box filter
+    // both stay inside it.
+    int levels = 1;
+    while ((atlas.padding >> levels) >= 2)
+        levels++;
+    return std::min(levels, mipLevels(atlas.pageSize, atlas.pageSize));
+}
+
+std::vector<GLuint> uploadAtlas(const Atlas &atlas, const std::string &mipCacheDir)
+{
+    std::vector<GLuint> textures;
+    for (const Image &page : atlas.pages)
+        textures.push_back(createMipmappedTexture(loadMipChain(page, mipCacheDir, atlasMipLevels(atlas))));
+
+    return textures;
+}
@@ -0,0 +1,54 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include "app_gl.h"
+#include "util.h"
+
+#include <vector>
+
+/* Largest atlas page; a smaller driver texture limit wins. */
+static constexpr int kAtlasMaxPageSize {4096};
+/* Wide enough for the atlas pages to keep four mip levels. */
+static constexpr int kAtlasPadding {16};
+
+/* Where one source image ended up inside the atlas. */
+struct AtlasEntry {
+    int page {0};
+    int width {0};
+    int height {0};
+    float u0 {0.0f};
+    float v0 {0.0f};
+    float u1 {0.0f};
+    float v1 {0.0f};
+};
+
+/* One or more square RGBA8 pages holding many logos. */
+struct Atlas {
+    /* Side of every page, sized to what they hold. */
+    int pageSize {0};
+    int padding {0};
+    std::vector<Image> pages;
+    /* One entry per input image, in input order. */
+    std::vector<AtlasEntry> entries;
+};
+
+/*
+ * Skyline bottom-left packing, tallest images first. Each image gets
+ * `padding` pixels of its own edge colour extruded around it so filtering
+ * never picks up a neighbour. Pages are the smallest power-of-two square,
+ * up to maxPageSize, that holds every image on one page; past that, more
+ * maxPageSize pages are opened. Throws if an image is larger than
+ * maxPageSize.
+ */
+Atlas packAtlas(const std::vector<Image> &images, int maxPageSize, int padding);
+
+/*
+ * Mip levels every backend keeps for the pages. They stop where a logo's box
+ * filter would start reaching past its padding into a neighbour.
+ */
+int atlasMipLevels(const Atlas &atlas);
+
+/* Creates one GL_TEXTURE_2D per page with atlasMipLevels() levels. */
+std::vector<GLuint> uploadAtlas(const Atlas &atlas, const std::string &mipCacheDir = "");
+
+#endif    // ATLAS_H
@@ -0,0 +1,184 @@
+#include "logo_blocks.h"
+#include "logos.h"
+#include "packed_logos.h"
+#include "soft_renderer.h"
+
+#include <chrono>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static constexpr float kMoveSpeed {4.0f};
+// Each measurement steps roughly this many logos in total.
+static constexpr double kWorkPerRun {2e8};
+
+struct AosLogo {
+    float x;
+    float y;
+    float vx;
+    float vy;
+};
+
+static void stepAos(std::vector<AosLogo> &logos, const Bounds &bounds, float speed)
+{
+    for (AosLogo &logo : logos) {
+        logo.x += logo.vx * speed;
+        logo.y += logo.vy * speed;
+
+        if (logo.x >= bounds.maxX)
+            logo.vx = -std::fabs(logo.vx);
+        if (logo.x <= bounds.minX)
+            logo.vx = std::fabs(logo.vx);
+        if (logo.y >= bounds.maxY)
+            logo.vy = -std::fabs(logo.vy);
+        if (logo.y <= bounds.minY)
+            logo.vy = std::fabs(logo.vy);
+    }
+}
+
+static double nsPerLogo(std::size_t count, const std::function<void()> &step)
+{
+    std::size_t ticks = static_cast<std::size_t>(std::max(3.0, kWorkPerRun / static_cast<double>(count)));
+
+    step();    // warm caches and page in memory
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < ticks; i++)
+        step();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+    return elapsed.count() / static_cast<double>(ticks * count);
+}
+
+static void benchLayouts(std::size_t count)
+{
+    Bounds bounds = logoBounds(800, 600, 120, 92);
+
+    Logos soa;
+    spawnLogos(soa, count, bounds);
+
+    std::vector<AosLogo> aos(count);
+    for (std::size_t i = 0; i < count; i++)
+        aos[i] = {soa.x[i], soa.y[i], soa.vx[i], soa.vy[i]};
+
+    LogoBlocks<8> blocks8;
+    blocks8.assign(soa);
+    LogoBlocks<16> blocks16;
+    blocks16.assign(soa);
+
+    std::cout << count << " logos (ns/logo)" << std::endl;
+    std::cout << "  aos       " << nsPerLogo(count, [&] { stepAos(aos, bounds, kMoveSpeed); }) << std::endl;
+    std::cout << "  soa       " << nsPerLogo(count, [&] { stepLogos(soa, bounds, kMoveSpeed); }) << std::endl;
+    std::cout << "  aosoa<8>  " << nsPerLogo(count, [&] { stepLogoBlocks(blocks8, bounds, kMoveSpeed); }) << std::endl;
+    std::cout << "  aosoa<16> " << nsPerLogo(count, [&] { stepLogoBlocks(blocks16, bounds, kMoveSpeed); }) << std::endl;
+
+    PackedLogos packed;
+    packed.init(800, 600, kMoveSpeed);
+    packed.pack(soa);
+    std::cout << "  packed    " << nsPerLogo(count, [&] { packed.step(bounds); }) << std::endl;
+
+    // Round-trip error of the 16-bit positions, which must stay sub-pixel.
+    Logos unpacked;
+    packed.pack(soa);
+    packed.unpack(unpacked);
+    float maxError = 0.0f;
+    for (std::size_t i = 0; i < count; i++)
+        maxError = std::max({maxError, std::fabs(unpacked.x[i] - soa.x[i]), std::fabs(unpacked.y[i] - soa.y[i])});
+    std::cout << "  packed round-trip error " << maxError << " px" << std::endl;
+}
+
+/* A 120x92 disc with a soft edge, standing in for a logo. */
+static Image benchLogo()
+{
+    Image image;
+    image.width = 120;
+    image.height = 92;
+    image.pixels.resize(static_cast<std::size_t>(image.width) * image.height * 4);
+    for (int y = 0; y < image.height; y++) {
+        for (int x = 0; x < image.width; x++) {
+            const float dx = (static_cast<float>(x) - 60.0f) / 60.0f;
+            const float dy = (static_cast<float>(y) - 46.0f) / 46.0f;
+            const float alpha = std::max(0.0f, std::min(1.0f, (1.0f - std::sqrt(dx * dx + dy * dy)) * 8.0f));
+            unsigned char *pixel = &image.pixels[(static_cast<std::size_t>(y) * image.width + x) * 4];
+            pixel[0] = static_cast<unsigned char>(x * 2);
+            pixel[1] = static_cast<unsigned char>(y * 2);
+            pixel[2] = 200;
+            pixel[3] = static_cast<unsigned char>(alpha * 255.0f);
+        }
+    }
+    return image;
+}
+
+static void benchSoftware(std::size_t count, int width, int height, const char *label)
+{
+    constexpr int kFrames {30};
+
+    Bounds bounds = logoBounds(width, height, 120, 92);
+    Logos logos;
+    spawnLogos(logos, count, bounds);
+
+    SoftRenderer renderer;
+    renderer.init(width, height);
+    renderer.setImages({benchLogo()});
+    renderer.render(logos, 0xff000000);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < kFrames; frame++) {
+        stepLogos(logos, bounds, kMoveSpeed);
+        renderer.render(logos, 0xff000000);
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << count << " logos, software " << label << ": " << elapsed.count() / kFrames << " ms/frame" << std::endl;
+}
+
+/* Positive decimal count, or 0 if arg is not one. */
+static std::size_t parseCount(const std::string &arg)
+{
+    try {
+        std::size_t used = 0;
+        unsigned long long count = std::stoull(arg, &used);
+        if (used == arg.size() && std::isdigit(static_cast<unsigned char>(arg[0])))
+            return static_cast<std::size_t>(count);
+    } catch (const std::logic_error &) {
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<std::size_t> counts {1000, 100000, 10000000};
+    if (argc > 1) {
+        counts.clear();
+        for (int i = 1; i < argc; i++) {
+            const std::size_t count = parseCount(argv[i]);
+            if (count == 0) {
+                std::cerr << "Invalid logo count: " << argv[i] << "\n"
+                          << "Usage: dvd-bench [count...]\n"
+                          << "  Times each logo layout at every count (default 1000 100000 10000000),\n"
+                          << "  then the software renderer." << std::endl;
+                return 1;
+            }
+            counts.push_back(count);
+        }
+    }
+
+    for (std::size_t count : counts)
+        benchLayouts(count);
+
+    // Fill rate scales with the frame, so 4K shows what 1080p hides.
+    std::cout << "software renderer: " << SoftRenderer::simdPath() << " blend, " << std::max(1u, std::thread::hardware_concurrency()) << " threads"
+              << std::endl;
+    for (std::size_t count : {100, 1000, 5000}) {
+        benchSoftware(count, 1920, 1080, "1080p");
+        benchSoftware(count, 3840, 2160, "4K");
+    }
+
+    return 0;
+}
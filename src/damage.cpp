@@ -0,0 +1,111 @@
+#include "damage.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Past this share of dirty tiles a full clear is cheaper than many scissored ones.
+static constexpr float kMaxDirtyFraction {0.5f};
+static constexpr std::size_t kMaxRects {32};
+
+void DamageTracker::init(int width, int height)
+{
+    mWidth = width;
+    mHeight = height;
+    mColumns = (width + kTileSize - 1) / kTileSize;
+    mRows = (height + kTileSize - 1) / kTileSize;
+    mCurrent.assign(static_cast<std::size_t>(mColumns) * mRows, 0);
+    mHistory.clear();
+}
+
+void DamageTracker::add(float x, float y, float width, float height)
+{
+    // One extra pixel each side covers bilinear filtering at fractional
+    // positions.
+    const int left = static_cast<int>(std::floor(x - width * 0.5f)) - 1;
+    const int right = static_cast<int>(std::ceil(x + width * 0.5f)) + 1;
+    const int top = static_cast<int>(std::floor(y - height * 0.5f)) - 1;
+    const int bottom = static_cast<int>(std::ceil(y + height * 0.5f)) + 1;
+    if (right <= 0 || bottom <= 0 || left >= mWidth || top >= mHeight)
+        return;
+
+    const int column0 = std::max(left, 0) / kTileSize;
+    const int column1 = std::min(right - 1, mWidth - 1) / kTileSize;
+    const int row0 = std::max(top, 0) / kTileSize;
+    const int row1 = std::min(bottom - 1, mHeight - 1) / kTileSize;
+    for (int row = row0; row <= row1; row++)
+        std::fill(mCurrent.begin() + row * mColumns + column0, mCurrent.begin() + row * mColumns + column1 + 1, 1);
+}
+
+bool DamageTracker::regions(int bufferAge, std::vector<DamageRect> &rects) const
+{
+    rects.clear();
+
+    // Age 0 means the contents are undefined; age 1 is last frame's buffer,
+    // whose sprites have to be cleared as well as this frame's drawn.
+    if (bufferAge <= 0 || static_cast<std::size_t>(bufferAge) > mHistory.size())
+        return false;
+
+    std::vector<std::uint8_t> dirty = mCurrent;
+    for (int age = 1; age <= bufferAge; age++) {
+        const std::vector<std::uint8_t> &past = mHistory[static_cast<std::size_t>(age - 1)];
+        for (std::size_t i = 0; i < dirty.size(); i++)
+            dirty[i] |= past[i];
+    }
+
+    const auto dirtyTiles = static_cast<std::size_t>(std::count(dirty.begin(), dirty.end(), 1));
+    if (static_cast<float>(dirtyTiles) > kMaxDirtyFraction * static_cast<float>(dirty.size()))
+        return false;
+
+    // Runs of dirty tiles per row, grown downwards while the rows below have
+    // the exact same run.
+    for (int row = 0; row < mRows; row++) {
+        for (int column = 0; column < mColumns;) {
+            if (!dirty[row * mColumns + column]) {
+                column++;
+                continue;
+            }
+
+            int end = column;
+            while (end < mColumns && dirty[row * mColumns + end])
+                end++;
+
+            int rowEnd = row + 1;
+            while (rowEnd < mRows) {
+                auto first = dirty.begin() + rowEnd * mColumns;
+                const bool sameRun = std::all_of(first + column, first + end, [](std::uint8_t tile) { return tile == 1; })
+                                     && (column == 0 || !first[column - 1]) && (end == mColumns || !first[end]);
+                if (!sameRun)
+                    break;
+                std::fill(first + column, first + end, 0);
+                rowEnd++;
+            }
+
+            // Flip to a bottom-left origin and clip the last row and column
+            // to the window.
+            DamageRect rect;
+            rect.x = column * kTileSize;
+            rect.width = std::min(end * kTileSize, mWidth) - rect.x;
+            const int top = row * kTileSize;
+            const int bottom = std::min(rowEnd * kTileSize, mHeight);
+            rect.y = mHeight - bottom;
+            rect.height = bottom - top;
+            rects.push_back(rect);
+
+            column = end;
+        }
+    }
+
+    if (rects.size() > kMaxRects) {
+        rects.clear();
+        return false;
+    }
+    return true;
+}
+
+void DamageTracker::endFrame()
+{
+    mHistory.insert(mHistory.begin(), mCurrent);
+    if (mHistory.size() > kMaxAge)
+        mHistory.pop_back();
+    std::fill(mCurrent.begin(), mCurrent.end(), 0);
+}
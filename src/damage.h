@@ -0,0 +1,52 @@
+#ifndef DAMAGE_H
+#define DAMAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* Window-space rectangle with a bottom-left origin, as glScissor and EGL take it. */
+struct DamageRect {
+    int x {0};
+    int y {0};
+    int width {0};
+    int height {0};
+};
+
+/*
+ * Tracks which parts of the window changed, on a grid of kTileSize tiles.
+ * Sprites are added each frame by centre and size in world coordinates
+ * (top-left origin, one unit per pixel). The region to redraw for a back
+ * buffer that is `age` frames old is everything touched in those frames plus
+ * this one; a full redraw is asked for when the buffer age is unknown, the
+ * history is too short or most of the window changed anyway.
+ */
+class DamageTracker {
+public:
+    static constexpr int kTileSize {32};
+    static constexpr std::size_t kMaxAge {4};
+
+    void init(int width, int height);
+
+    void add(float x, float y, float width, float height);
+
+    /*
+     * Rectangles to redraw; false means redraw and present the whole window.
+     * With a bufferAge of 1 they are what changed since the last frame
+     * presented, which is what swap-with-damage wants.
+     */
+    bool regions(int bufferAge, std::vector<DamageRect> &rects) const;
+    /* Moves this frame's tiles into the history and starts a new frame. */
+    void endFrame();
+
+private:
+    int mWidth {0};
+    int mHeight {0};
+    int mColumns {0};
+    int mRows {0};
+    std::vector<std::uint8_t> mCurrent;
+    /* Tiles of previous frames, most recent first. */
+    std::vector<std::vector<std::uint8_t>> mHistory;
+};
+
+#endif    // DAMAGE_H
@@ -0,0 +1,137 @@
+#include "feedback_sim.h"
+#include "gl_state.h"
+#include "headless.h"
+#include "logos.h"
+#include "program_cache.h"
+#include "util.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*
+ * Checks FeedbackSim against stepLogos() on a headless context (llvmpipe is
+ * enough). Each tick the CPU steps a copy of the GPU's previous state, so
+ * rounding differences cannot pile up across ticks and any difference
+ * points at the tick that caused it. Where the context can, each step also
+ * feeds one of two trail slots, which must then hold exactly the positions
+ * the step wrote. Run from the assets directory, where
+ * simulate.glsl lives; exits non-zero on a mismatch.
+ *
+ * Usage: dvd-feedback-check [ticks] [logos]
+ */
+
+static constexpr int kArenaWidth {800};
+static constexpr int kArenaHeight {600};
+static constexpr float kSpeed {1.5f};
+// Positions are a few hundred pixels; the GPU may fuse the multiply-add.
+static constexpr float kTolerance {1e-3f};
+
+/* A velocity may differ where the position sits within rounding of an edge. */
+static bool nearEdge(float value, float min, float max)
+{
+    return std::fabs(value - min) <= kTolerance || std::fabs(value - max) <= kTolerance;
+}
+
+static std::size_t compare(const Logos &cpu, const Logos &gpu, const Bounds &bounds, std::size_t tick)
+{
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < cpu.size(); i++) {
+        const bool position = std::fabs(cpu.x[i] - gpu.x[i]) <= kTolerance && std::fabs(cpu.y[i] - gpu.y[i]) <= kTolerance;
+        const bool velocityX = cpu.vx[i] == gpu.vx[i] || nearEdge(cpu.x[i], bounds.minX, bounds.maxX);
+        const bool velocityY = cpu.vy[i] == gpu.vy[i] || nearEdge(cpu.y[i], bounds.minY, bounds.maxY);
+        if (position && velocityX && velocityY)
+            continue;
+
+        if (mismatches++ < 10) {
+            std::cerr << "tick " << tick << ", logo " << i << ": cpu (" << cpu.x[i] << ", " << cpu.y[i] << ") v (" << cpu.vx[i] << ", " << cpu.vy[i]
+                      << "), gpu (" << gpu.x[i] << ", " << gpu.y[i] << ") v (" << gpu.vx[i] << ", " << gpu.vy[i] << ")" << std::endl;
+        }
+    }
+    return mismatches;
+}
+
+static std::size_t compareTrail(const Logos &gpu, GLuint trailBuffer, GLintptr slot, std::size_t tick)
+{
+    std::vector<GLfloat> positions(gpu.size() * 2);
+    glBindBuffer(GL_ARRAY_BUFFER, trailBuffer);
+    glGetBufferSubData(GL_ARRAY_BUFFER, slot, static_cast<GLsizeiptr>(positions.size() * sizeof(GLfloat)), positions.data());
+    glBindBuffer(GL_ARRAY_BUFFER, GL_NONE);
+
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < gpu.size(); i++) {
+        if (positions[i * 2] == gpu.x[i] && positions[i * 2 + 1] == gpu.y[i])
+            continue;
+
+        if (mismatches++ < 10) {
+            std::cerr << "tick " << tick << ", logo " << i << ": trail (" << positions[i * 2] << ", " << positions[i * 2 + 1] << "), gpu (" << gpu.x[i] << ", "
+                      << gpu.y[i] << ")" << std::endl;
+        }
+    }
+    return mismatches;
+}
+
+int main(int argc, char **argv)
+{
+    try {
+        const std::size_t ticks = argc > 1 ? std::stoul(argv[1]) : 600;
+        const std::size_t count = argc > 2 ? std::stoul(argv[2]) : 10000;
+
+        HeadlessContext context;
+        context.init(kArenaWidth, kArenaHeight);
+        std::cout << "context: " << glGetString(GL_VERSION) << ", " << glGetString(GL_RENDERER) << std::endl;
+
+        // The logo size only sets how far in the bounds sit.
+        const Bounds bounds = logoBounds(kArenaWidth, kArenaHeight, 120, 92);
+        Logos logos;
+        std::srand(1);
+        spawnLogos(logos, count, bounds);
+
+        GlState state;
+        ProgramCache programs;
+        programs.init("");
+        const bool trails = glVersionAtLeast(4, 0) || GLEW_ARB_transform_feedback3;
+        FeedbackSim sim;
+        sim.init(programs, logos, state, trails);
+
+        const GLsizeiptr slotBytes = static_cast<GLsizeiptr>(count * sizeof(GLfloat) * 2);
+        GLuint trailBuffer = GL_NONE;
+        if (trails) {
+            glGenBuffers(1, &trailBuffer);
+            glBindBuffer(GL_ARRAY_BUFFER, trailBuffer);
+            glBufferData(GL_ARRAY_BUFFER, slotBytes * 2, nullptr, GL_DYNAMIC_COPY);
+            glBindBuffer(GL_ARRAY_BUFFER, GL_NONE);
+        }
+
+        Logos cpu;
+        Logos gpu;
+        std::size_t mismatches = 0;
+        for (std::size_t tick = 1; tick <= ticks; tick++) {
+            sim.readback(cpu);
+            stepLogos(cpu, bounds, kSpeed);
+            const GLintptr slot = static_cast<GLintptr>(tick % 2) * slotBytes;
+            sim.step(bounds, kSpeed, state, trailBuffer, slot);
+            sim.readback(gpu);
+            mismatches += compare(cpu, gpu, bounds, tick);
+            if (trails)
+                mismatches += compareTrail(gpu, trailBuffer, slot, tick);
+        }
+        glDeleteBuffers(1, &trailBuffer);
+
+        const GLenum error = glGetError();
+        if (error != GL_NO_ERROR)
+            throw std::runtime_error("GL error " + std::to_string(error));
+
+        std::cout << count << " logos over " << ticks << " ticks" << (trails ? " with trails" : "") << ": " << mismatches << " mismatches" << std::endl;
+        return mismatches == 0 ? 0 : 1;
+    } catch (const std::logic_error &) {
+        std::cerr << "Usage: dvd-feedback-check [ticks] [logos]" << std::endl;
+        return 1;
+    } catch (const std::runtime_error &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
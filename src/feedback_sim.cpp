@@ -0,0 +1,136 @@
+#include "feedback_sim.h"
+
+#include "program.h"
+#include "util.h"
+
+#include <stdexcept>
+#include <vector>
+
+static constexpr GLsizei kStride {sizeof(GLfloat) * 4};
+
+FeedbackSim::~FeedbackSim()
+{
+    destroy();
+}
+
+ProgramDesc FeedbackSim::programDesc(bool trails)
+{
+    // gl_NextBuffer moves the positions for the trails to binding 1.
+    if (trails)
+        return {{{GL_VERTEX_SHADER, "simulate.glsl"}}, {"outPos", "outVelocity", "gl_NextBuffer", "outTrail"}};
+    return {{{GL_VERTEX_SHADER, "simulate.glsl"}}, {"outPos", "outVelocity"}};
+}
+
+void FeedbackSim::init(ProgramCache &programs, const Logos &logos, GlState &state, bool trails)
+{
+    destroy();
+
+    if (trails && !glVersionAtLeast(4, 0) && !GLEW_ARB_transform_feedback3)
+        throw std::runtime_error("Feeding trails from transform feedback needs GL 4.0 or ARB_transform_feedback3");
+
+    mCount = logos.size();
+    mTrails = trails;
+
+    mProgram = programs.build(programDesc(trails));
+
+    ProgramReflection reflection;
+    reflection.reflect(mProgram);
+    mBoundsLocation = reflection.location("bounds");
+    mSpeedLocation = reflection.location("speed");
+    mUploadedBounds = Bounds {};
+    mUploadedSpeed = 0.0f;
+
+    std::vector<GLfloat> vertices(mCount * 4);
+    for (std::size_t i = 0; i < mCount; i++) {
+        vertices[i * 4 + 0] = logos.x[i];
+        vertices[i * 4 + 1] = logos.y[i];
+        vertices[i * 4 + 2] = logos.vx[i];
+        vertices[i * 4 + 3] = logos.vy[i];
+    }
+
+    glGenBuffers(2, mVbo);
+    glGenVertexArrays(2, mVao);
+    for (int i = 0; i < 2; i++) {
+        glBindBuffer(GL_ARRAY_BUFFER, mVbo[i]);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_DYNAMIC_COPY);
+
+        state.bindVertexArray(mVao[i]);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, kStride, reinterpret_cast<void *>(0));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, kStride, reinterpret_cast<void *>(sizeof(GLfloat) * 2));
+    }
+    state.bindVertexArray(GL_NONE);
+    glBindBuffer(GL_ARRAY_BUFFER, GL_NONE);
+
+    mCurrent = 0;
+}
+
+void FeedbackSim::destroy()
+{
+    if (mProgram) {
+        glDeleteProgram(mProgram);
+        glDeleteVertexArrays(2, mVao);
+        glDeleteBuffers(2, mVbo);
+    }
+    mProgram = GL_NONE;
+    mVbo[0] = mVbo[1] = GL_NONE;
+    mVao[0] = mVao[1] = GL_NONE;
+    mCount = 0;
+}
+
+void FeedbackSim::step(const Bounds &bounds, float speed, GlState &state, GLuint trailBuffer, GLintptr trailOffset)
+{
+    const int next = 1 - mCurrent;
+
+    state.useProgram(mProgram);
+    if (bounds.minX != mUploadedBounds.minX || bounds.maxX != mUploadedBounds.maxX || bounds.minY != mUploadedBounds.minY || bounds.maxY != mUploadedBounds.maxY) {
+        glUniform4f(mBoundsLocation, bounds.minX, bounds.maxX, bounds.minY, bounds.maxY);
+        mUploadedBounds = bounds;
+    }
+    if (speed != mUploadedSpeed) {
+        glUniform1f(mSpeedLocation, speed);
+        mUploadedSpeed = speed;
+    }
+
+    state.enable(GL_RASTERIZER_DISCARD);
+    state.bindVertexArray(mVao[mCurrent]);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, mVbo[next]);
+    if (mTrails)
+        glBindBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, 1, trailBuffer, trailOffset, static_cast<GLsizeiptr>(mCount * sizeof(GLfloat) * 2));
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(mCount));
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, GL_NONE);
+    if (mTrails)
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 1, GL_NONE);
+    state.disable(GL_RASTERIZER_DISCARD);
+
+    mCurrent = next;
+}
+
+void FeedbackSim::readback(Logos &logos) const
+{
+    std::vector<GLfloat> vertices(mCount * 4);
+    glBindBuffer(GL_ARRAY_BUFFER, mVbo[mCurrent]);
+    glGetBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(GLfloat), vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, GL_NONE);
+
+    logos.resize(mCount);
+    for (std::size_t i = 0; i < mCount; i++) {
+        logos.x[i] = vertices[i * 4 + 0];
+        logos.y[i] = vertices[i * 4 + 1];
+        logos.vx[i] = vertices[i * 4 + 2];
+        logos.vy[i] = vertices[i * 4 + 3];
+    }
+}
+
+GLuint FeedbackSim::buffer() const
+{
+    return mVbo[mCurrent];
+}
+
+std::size_t FeedbackSim::size() const
+{
+    return mCount;
+}
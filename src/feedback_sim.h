@@ -0,0 +1,53 @@
+#ifndef FEEDBACK_SIM_H
+#define FEEDBACK_SIM_H
+
+#include "app_gl.h"
+#include "gl_state.h"
+#include "logos.h"
+#include "program_cache.h"
+
+#include <cstddef>
+
+/*
+ * Runs stepLogos() on the GPU with transform feedback, ping-ponging between
+ * two interleaved {pos, velocity} buffers. Only uses GL 3.3 entry points so it
+ * works on drivers without compute shaders.
+ */
+class FeedbackSim {
+public:
+    ~FeedbackSim();
+
+    /* The program init() builds, so it can be prepared early. */
+    static ProgramDesc programDesc(bool trails = false);
+
+    /*
+     * With trails, step() also captures the new positions into a second
+     * buffer, so motion trails are fed on the GPU and never read the state
+     * back. Needs GL 4.0 or ARB_transform_feedback3.
+     */
+    void init(ProgramCache &programs, const Logos &logos, GlState &state, bool trails = false);
+    void destroy();
+
+    /* With trails, the new positions land as vec2s at trailOffset in trailBuffer. */
+    void step(const Bounds &bounds, float speed, GlState &state, GLuint trailBuffer = GL_NONE, GLintptr trailOffset = 0);
+    /* Waits for the GPU to finish every step so far; for checks, not per tick. */
+    void readback(Logos &logos) const;
+
+    /* Buffer with the current {pos, velocity} of each logo, one vec4 apiece. */
+    GLuint buffer() const;
+    std::size_t size() const;
+
+private:
+    GLuint mProgram {GL_NONE};
+    GLuint mVbo[2] {GL_NONE, GL_NONE};
+    GLuint mVao[2] {GL_NONE, GL_NONE};
+    GLint mBoundsLocation {-1};
+    GLint mSpeedLocation {-1};
+    Bounds mUploadedBounds;
+    float mUploadedSpeed {0.0f};
+    std::size_t mCount {0};
+    int mCurrent {0};
+    bool mTrails {false};
+};
+
+#endif    // FEEDBACK_SIM_H
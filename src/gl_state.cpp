@@ -0,0 +1,183 @@
+#include "gl_state.h"
+
+#include <stdexcept>
+#include <string>
+
+static int capIndex(GLenum cap)
+{
+    switch (cap) {
+        case GL_BLEND:
+            return 0;
+        case GL_RASTERIZER_DISCARD:
+            return 1;
+        case GL_SCISSOR_TEST:
+            return 2;
+        default:
+            return -1;
+    }
+}
+
+static int targetIndex(GLenum target)
+{
+    switch (target) {
+        case GL_TEXTURE_2D:
+            return 0;
+        case GL_TEXTURE_2D_ARRAY:
+            return 1;
+        default:
+            return -1;
+    }
+}
+
+static GLenum targetBinding(GLenum target)
+{
+    return target == GL_TEXTURE_2D_ARRAY ? GL_TEXTURE_BINDING_2D_ARRAY : GL_TEXTURE_BINDING_2D;
+}
+
+void GlState::setValidation(bool validate)
+{
+    mValidate = validate;
+}
+
+void GlState::invalidate()
+{
+    mProgramValid = false;
+    mVertexArrayValid = false;
+    mActiveTextureValid = false;
+    for (auto &unit : mTexturesValid) {
+        for (bool &valid : unit)
+            valid = false;
+    }
+    for (bool &valid : mCapsValid)
+        valid = false;
+    mBlendValid = false;
+}
+
+void GlState::validate(GLenum query, GLint expected, const char *what) const
+{
+    if (!mValidate)
+        return;
+
+    GLint actual = 0;
+    glGetIntegerv(query, &actual);
+    if (actual != expected) {
+        throw std::runtime_error(std::string("GL state tracker out of sync: ") + what + " is " + std::to_string(actual) + ", expected " + std::to_string(expected));
+    }
+}
+
+bool GlState::known(bool valid)
+{
+    if (valid)
+        mElided++;
+    else
+        mIssued++;
+    return valid;
+}
+
+void GlState::useProgram(GLuint program)
+{
+    if (mProgramValid)
+        validate(GL_CURRENT_PROGRAM, static_cast<GLint>(mProgram), "program");
+    if (known(mProgramValid && mProgram == program))
+        return;
+
+    glUseProgram(program);
+    mProgram = program;
+    mProgramValid = true;
+}
+
+void GlState::bindVertexArray(GLuint vertexArray)
+{
+    if (mVertexArrayValid)
+        validate(GL_VERTEX_ARRAY_BINDING, static_cast<GLint>(mVertexArray), "vertex array");
+    if (known(mVertexArrayValid && mVertexArray == vertexArray))
+        return;
+
+    glBindVertexArray(vertexArray);
+    mVertexArray = vertexArray;
+    mVertexArrayValid = true;
+}
+
+void GlState::activeTexture(GLenum unit)
+{
+    if (mActiveTextureValid)
+        validate(GL_ACTIVE_TEXTURE, static_cast<GLint>(mActiveTexture), "active texture");
+    if (known(mActiveTextureValid && mActiveTexture == unit))
+        return;
+
+    glActiveTexture(unit);
+    mActiveTexture = unit;
+    mActiveTextureValid = true;
+}
+
+void GlState::bindTexture(GLenum target, GLuint texture)
+{
+    const int unit = mActiveTextureValid ? static_cast<int>(mActiveTexture - GL_TEXTURE0) : -1;
+    const int index = targetIndex(target);
+    if (unit < 0 || unit >= kTextureUnits || index < 0) {
+        mIssued++;
+        glBindTexture(target, texture);
+        return;
+    }
+
+    if (mTexturesValid[unit][index])
+        validate(targetBinding(target), static_cast<GLint>(mTextures[unit][index]), "texture binding");
+    if (known(mTexturesValid[unit][index] && mTextures[unit][index] == texture))
+        return;
+
+    glBindTexture(target, texture);
+    mTextures[unit][index] = texture;
+    mTexturesValid[unit][index] = true;
+}
+
+void GlState::setCap(GLenum cap, bool enabled)
+{
+    const int index = capIndex(cap);
+    if (index < 0) {
+        mIssued++;
+        enabled ? glEnable(cap) : glDisable(cap);
+        return;
+    }
+
+    if (mCapsValid[index] && mValidate && (glIsEnabled(cap) == GL_TRUE) != mCaps[index])
+        throw std::runtime_error("GL state tracker out of sync: capability " + std::to_string(cap));
+    if (known(mCapsValid[index] && mCaps[index] == enabled))
+        return;
+
+    enabled ? glEnable(cap) : glDisable(cap);
+    mCaps[index] = enabled;
+    mCapsValid[index] = true;
+}
+
+void GlState::enable(GLenum cap)
+{
+    setCap(cap, true);
+}
+
+void GlState::disable(GLenum cap)
+{
+    setCap(cap, false);
+}
+
+void GlState::blendFunc(GLenum src, GLenum dst)
+{
+    if (mBlendValid) {
+        validate(GL_BLEND_SRC_RGB, static_cast<GLint>(mBlendSrc), "blend source");
+        validate(GL_BLEND_DST_RGB, static_cast<GLint>(mBlendDst), "blend destination");
+    }
+    if (known(mBlendValid && mBlendSrc == src && mBlendDst == dst))
+        return;
+
+    glBlendFunc(src, dst);
+    mBlendSrc = src;
+    mBlendDst = dst;
+    mBlendValid = true;
+}
+
+void GlState::collect(FrameStats &stats)
+{
+    stats.stateCalls += mIssued;
+    stats.stateCallsElided += mElided;
+    mIssued = 0;
+    mElided = 0;
+}
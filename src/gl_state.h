@@ -0,0 +1,63 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include "app_gl.h"
+#include "stats.h"
+
+#include <cstddef>
+
+/*
+ * Shadow copy of the bits of GL state the render loop touches every frame.
+ * Calls that would not change anything are skipped and counted. With
+ * validation on, the shadow state is checked against glGet* before each
+ * decision and a mismatch throws.
+ *
+ * Anything that changes this state behind the tracker's back must call
+ * invalidate() afterwards.
+ */
+class GlState {
+public:
+    void setValidation(bool validate);
+    void invalidate();
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vertexArray);
+    void activeTexture(GLenum unit);
+    void bindTexture(GLenum target, GLuint texture);
+    void enable(GLenum cap);
+    void disable(GLenum cap);
+    void blendFunc(GLenum src, GLenum dst);
+
+    /* Adds the calls issued/elided since the last collect() to stats. */
+    void collect(FrameStats &stats);
+
+private:
+    static constexpr int kTextureUnits {8};
+    static constexpr int kTextureTargets {2};
+    static constexpr int kCaps {3};
+
+    void setCap(GLenum cap, bool enabled);
+    void validate(GLenum query, GLint expected, const char *what) const;
+    bool known(bool valid);
+
+    bool mValidate {false};
+
+    GLuint mProgram {GL_NONE};
+    bool mProgramValid {false};
+    GLuint mVertexArray {GL_NONE};
+    bool mVertexArrayValid {false};
+    GLenum mActiveTexture {GL_TEXTURE0};
+    bool mActiveTextureValid {false};
+    GLuint mTextures[kTextureUnits][kTextureTargets] {};
+    bool mTexturesValid[kTextureUnits][kTextureTargets] {};
+    bool mCaps[kCaps] {};
+    bool mCapsValid[kCaps] {};
+    GLenum mBlendSrc {GL_ONE};
+    GLenum mBlendDst {GL_ZERO};
+    bool mBlendValid {false};
+
+    std::size_t mIssued {0};
+    std::size_t mElided {0};
+};
+
+#endif    // GL_STATE_H
@@ -0,0 +1,97 @@
+#include "golden.h"
+
+#include "atlas.h"
+#include "gl_state.h"
+#include "instance_renderer.h"
+#include "mipmap.h"
+#include "program.h"
+#include "program_cache.h"
+#include "stats.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+GoldenScene goldenScene(std::size_t count)
+{
+    GoldenScene scene;
+
+    // logo.png itself, then with red swapped for green and for blue, so a
+    // logo drawn with the wrong image shows up as the wrong colour.
+    const Image logo = loadImage("logo.png");
+    for (std::size_t channel = 0; channel < 3; channel++) {
+        Image tinted = logo;
+        for (std::size_t i = 0; i < tinted.pixels.size(); i += 4)
+            std::swap(tinted.pixels[i], tinted.pixels[i + channel]);
+        scene.images.push_back(std::move(tinted));
+    }
+
+    const int width = static_cast<int>(logo.width * kGoldenScale);
+    const int height = static_cast<int>(logo.height * kGoldenScale);
+    std::srand(1);
+    spawnLogos(scene.logos, count, logoBounds(kGoldenWidth, kGoldenHeight, width, height));
+    return scene;
+}
+
+Image renderGolden(const GoldenScene &scene)
+{
+    // Top-left origin, one unit per pixel, as App's camera ends up.
+    CameraBlock camera {};
+    camera.view[0] = camera.view[5] = camera.view[10] = camera.view[15] = 1.0f;
+    camera.projection[0] = 2.0f / kGoldenWidth;
+    camera.projection[5] = -2.0f / kGoldenHeight;
+    camera.projection[10] = -1.0f;
+    camera.projection[12] = -1.0f;
+    camera.projection[13] = 1.0f;
+    camera.projection[15] = 1.0f;
+
+    GLuint cameraUbo = GL_NONE;
+    glGenBuffers(1, &cameraUbo);
+    glBindBuffer(GL_UNIFORM_BUFFER, cameraUbo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(camera), &camera, GL_STATIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, kCameraBinding, cameraUbo);
+
+    std::vector<Image> images = scene.images;
+    for (Image &image : images)
+        premultiplyAlpha(image);
+
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    const Atlas atlas = packAtlas(images, std::min(kAtlasMaxPageSize, static_cast<int>(maxTextureSize)), kAtlasPadding);
+    std::vector<GLuint> pages = uploadAtlas(atlas);
+
+    ProgramCache programs;
+    programs.init("");
+    InstanceRenderer renderer;
+    renderer.init(programs, scene.logos.size(), atlas, pages);
+    renderer.setScale(kGoldenScale);
+
+    GlState state;
+    FrameStats stats;
+    state.invalidate();
+    state.enable(GL_BLEND);
+    state.blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glViewport(0, 0, kGoldenWidth, kGoldenHeight);
+    glClearColor((kGoldenClearColour & 0xff) / 255.0f, (kGoldenClearColour >> 8 & 0xff) / 255.0f, (kGoldenClearColour >> 16 & 0xff) / 255.0f,
+                 (kGoldenClearColour >> 24) / 255.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    renderer.update(scene.logos, stats);
+    renderer.draw(state, stats);
+    Image image = readFramebuffer(kGoldenWidth, kGoldenHeight);
+
+    renderer.destroy();
+    glDeleteTextures(static_cast<GLsizei>(pages.size()), pages.data());
+    glDeleteBuffers(1, &cameraUbo);
+    return image;
+}
+
+int maxChannelDifference(const Image &a, const Image &b)
+{
+    if (a.width != b.width || a.height != b.height || a.pixels.size() != b.pixels.size())
+        return 255;
+
+    int difference = 0;
+    for (std::size_t i = 0; i < a.pixels.size(); i++)
+        difference = std::max(difference, std::abs(a.pixels[i] - b.pixels[i]));
+    return difference;
+}
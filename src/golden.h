@@ -0,0 +1,40 @@
+#ifndef GOLDEN_H
+#define GOLDEN_H
+
+#include "logos.h"
+#include "util.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * The scene the backend checks draw: seeded logos in three tints of
+ * logo.png over a fixed clear colour, at half size. That is exactly mip
+ * level 1, so GL's blend between the two nearest levels and SoftRenderer's
+ * nearest level sample the same texels. The GL instanced renderer's picture
+ * of it on a headless context is the reference the other backends are
+ * compared with. Run from a directory holding logo.png and the instanced
+ * shaders.
+ */
+static constexpr int kGoldenWidth {800};
+static constexpr int kGoldenHeight {600};
+static constexpr float kGoldenScale {0.5f};
+/* RGBA8, red in the lowest byte, as LogoBackend::init() takes it. */
+static constexpr std::uint32_t kGoldenClearColour {0xff1a1a4c};
+
+struct GoldenScene {
+    /* Straight alpha, as LogoBackend::setImages() takes them. */
+    std::vector<Image> images;
+    Logos logos;
+};
+
+GoldenScene goldenScene(std::size_t count);
+
+/* Needs a current GL context, such as HeadlessContext's, of kGoldenWidth x kGoldenHeight. */
+Image renderGolden(const GoldenScene &scene);
+
+/* Largest difference in any channel of any pixel; images of different sizes differ by 255. */
+int maxChannelDifference(const Image &a, const Image &b);
+
+#endif    // GOLDEN_H
@@ -0,0 +1,106 @@
+#include "headless.h"
+
+#ifdef __linux__
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <stdexcept>
+#include <string>
+
+HeadlessContext::~HeadlessContext()
+{
+    destroy();
+}
+
+void HeadlessContext::init(int width, int height, bool es)
+{
+    destroy();
+
+#ifdef __linux__
+    EGLDisplay display = eglGetPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+        throw std::runtime_error("Failed to open a surfaceless EGL display (needs EGL_MESA_platform_surfaceless).");
+    mDisplay = display;
+
+    // No config and no surface: everything is drawn into our own framebuffer.
+    EGLContext context = EGL_NO_CONTEXT;
+    if (!es && eglBindAPI(EGL_OPENGL_API)) {
+        const EGLint versions[][2] {{4, 5}, {3, 3}};
+        for (const EGLint *version : versions) {
+            const EGLint attributes[] {
+                EGL_CONTEXT_MAJOR_VERSION, version[0],
+                EGL_CONTEXT_MINOR_VERSION, version[1],
+                EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                EGL_NONE,
+            };
+            context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes);
+            if (context != EGL_NO_CONTEXT)
+                break;
+        }
+    }
+    if (context == EGL_NO_CONTEXT && eglBindAPI(EGL_OPENGL_ES_API)) {
+        const EGLint attributes[] {
+            EGL_CONTEXT_MAJOR_VERSION, 3,
+            EGL_CONTEXT_MINOR_VERSION, 1,
+            EGL_NONE,
+        };
+        context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes);
+    }
+    if (context == EGL_NO_CONTEXT)
+        throw std::runtime_error("Failed to create a GL 4.5 or 3.3 core or GLES 3.1 context on the surfaceless EGL display.");
+    mContext = context;
+
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+        throw std::runtime_error("Failed to make the headless GL context current.");
+
+    // GLEW also tries to load GLX, which fails without an X display even
+    // though every GL entry point it needs was found.
+    glewExperimental = true;
+    GLenum err = glewInit();
+    if (err != GLEW_OK && err != GLEW_ERROR_NO_GLX_DISPLAY)
+        throw std::runtime_error(std::string("Failed to load GL: ") + reinterpret_cast<const char *>(glewGetErrorString(err)));
+
+    // Plain binds rather than DSA, which GLES lacks. Sprites are 2D and
+    // drawn in order, so there is no depth attachment.
+    glGenRenderbuffers(1, &mColour);
+    glBindRenderbuffer(GL_RENDERBUFFER, mColour);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+    glGenFramebuffers(1, &mFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, mColour);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        throw std::runtime_error("Headless framebuffer is incomplete.");
+
+    glViewport(0, 0, width, height);
+#else
+    (void)width;
+    (void)height;
+    (void)es;
+    throw std::runtime_error("Headless rendering needs EGL and is only available on Linux.");
+#endif
+}
+
+void HeadlessContext::destroy()
+{
+#ifdef __linux__
+    if (mContext) {
+        glDeleteFramebuffers(1, &mFramebuffer);
+        glDeleteRenderbuffers(1, &mColour);
+        eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(mDisplay, mContext);
+    }
+    if (mDisplay)
+        eglTerminate(mDisplay);
+#endif
+    mDisplay = nullptr;
+    mContext = nullptr;
+    mFramebuffer = mColour = GL_NONE;
+}
+
+bool HeadlessContext::active() const
+{
+    return mContext != nullptr;
+}
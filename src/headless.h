@@ -0,0 +1,30 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include "app_gl.h"
+
+/*
+ * A GL 4.5 core context with no window, from EGL's surfaceless platform
+ * (EGL_MESA_platform_surfaceless), rendering into a framebuffer object the
+ * size the window would have been. Falls back to GL 3.3 core, then to GLES
+ * 3.1 where desktop GL is missing. Works on Mesa's llvmpipe, so it needs no
+ * GPU or display server. Linux only; init() throws elsewhere.
+ */
+class HeadlessContext {
+public:
+    ~HeadlessContext();
+
+    /* Creates the context, loads GL and leaves the framebuffer bound. es skips desktop GL. */
+    void init(int width, int height, bool es = false);
+    void destroy();
+
+    bool active() const;
+
+private:
+    void *mDisplay {nullptr};
+    void *mContext {nullptr};
+    GLuint mFramebuffer {GL_NONE};
+    GLuint mColour {GL_NONE};
+};
+
+#endif    // HEADLESS_H
@@ -0,0 +1,137 @@
+#include "instance_renderer.h"
+
+#include "util.h"
+
+#include <algorithm>
+#include <cstddef>
+
+InstanceRenderer::~InstanceRenderer()
+{
+    destroy();
+}
+
+static ProgramDesc instancedProgram(const std::string &defines)
+{
+    const bool es = glIsEs();
+    return {{
+        {GL_VERTEX_SHADER, es ? "instanced_es_vert.glsl" : "instanced_vert.glsl", defines},
+        {GL_FRAGMENT_SHADER, es ? "instanced_es_frag.glsl" : "instanced_frag.glsl", defines},
+    }};
+}
+
+ProgramDesc InstanceRenderer::atlasProgram()
+{
+    return instancedProgram("");
+}
+
+ProgramDesc InstanceRenderer::arrayProgram()
+{
+    return instancedProgram("#define TEXTURE_ARRAY\n");
+}
+
+ProgramDesc InstanceRenderer::bindlessProgram()
+{
+    return instancedProgram("#define BINDLESS\n");
+}
+
+void InstanceRenderer::init(ProgramCache &programs, std::size_t capacity, const Atlas &atlas, const std::vector<GLuint> &pages)
+{
+    destroy();
+
+    mProgram = programs.build(atlasProgram());
+
+    mBatch.init(capacity);
+    mBatchProgram = mBatch.addProgram(mProgram);
+
+    std::vector<std::uint16_t> pageTextures;
+    for (GLuint page : pages)
+        pageTextures.push_back(mBatch.addTexture(GL_TEXTURE_2D, page));
+
+    mVariants.clear();
+    for (const AtlasEntry &entry : atlas.entries) {
+        mVariants.push_back({pageTextures[static_cast<std::size_t>(entry.page)], static_cast<float>(entry.width), static_cast<float>(entry.height), 0.0f, entry.u0, entry.v0, entry.u1, entry.v1, 0});
+    }
+}
+
+void InstanceRenderer::initArray(ProgramCache &programs, std::size_t capacity, GLuint arrayTexture, std::size_t layers, int width, int height)
+{
+    destroy();
+
+    mProgram = programs.build(arrayProgram());
+
+    mBatch.init(capacity);
+    mBatchProgram = mBatch.addProgram(mProgram);
+    const std::uint16_t texture = mBatch.addTexture(GL_TEXTURE_2D_ARRAY, arrayTexture);
+
+    mVariants.clear();
+    for (std::size_t layer = 0; layer < layers; layer++)
+        mVariants.push_back({texture, static_cast<float>(width), static_cast<float>(height), static_cast<float>(layer), 0.0f, 0.0f, 1.0f, 1.0f, 0});
+}
+
+void InstanceRenderer::initBindless(ProgramCache &programs, std::size_t capacity, const std::vector<GLuint> &textures, const std::vector<Image> &images)
+{
+    destroy();
+
+    mProgram = programs.build(bindlessProgram());
+
+    mBatch.init(capacity);
+    mBatchProgram = mBatch.addProgram(mProgram);
+    // Every sprite carries its own texture, so there is nothing to bind and
+    // nothing to split draws on.
+    const std::uint16_t texture = mBatch.addTexture(GL_NONE, GL_NONE);
+
+    // Residency is set once here rather than per frame; handles stay valid
+    // until the textures are deleted.
+    mVariants.clear();
+    for (std::size_t i = 0; i < textures.size(); i++) {
+        const GLuint64 handle = glGetTextureHandleARB(textures[i]);
+        glMakeTextureHandleResidentARB(handle);
+        mResidentHandles.push_back(handle);
+        mVariants.push_back({texture, static_cast<float>(images[i].width), static_cast<float>(images[i].height), 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, handle});
+    }
+}
+
+void InstanceRenderer::destroy()
+{
+    for (GLuint64 handle : mResidentHandles)
+        glMakeTextureHandleNonResidentARB(handle);
+    mResidentHandles.clear();
+
+    if (mProgram) {
+        glDeleteProgram(mProgram);
+        mBatch.destroy();
+    }
+    mProgram = GL_NONE;
+    mVariants.clear();
+}
+
+void InstanceRenderer::setScale(float scale)
+{
+    mScale = scale;
+}
+
+void InstanceRenderer::update(const Logos &logos, FrameStats &stats, DamageTracker *damage)
+{
+    mBatch.begin(stats);
+    for (std::size_t i = 0; i < logos.size(); i++) {
+        const Variant &variant = mVariants[logos.id[i] % mVariants.size()];
+        if (damage)
+            damage->add(logos.x[i], logos.y[i], variant.width * mScale, variant.height * mScale);
+        mBatch.submit(mBatchProgram, variant.texture, BlendMode::Premultiplied, 0.0f);
+    }
+
+    // Keys first, so each instance can go straight to its sorted slot.
+    mBatch.sort();
+    const std::size_t count = std::min(logos.size(), mBatch.capacity());
+    for (std::size_t i = 0; i < count; i++) {
+        const Variant &variant = mVariants[logos.id[i] % mVariants.size()];
+        const std::uint32_t handleLow = static_cast<std::uint32_t>(variant.handle);
+        const std::uint32_t handleHigh = static_cast<std::uint32_t>(variant.handle >> 32);
+        mBatch.instance(i) = {logos.x[i], logos.y[i], variant.width * mScale, variant.height * mScale, variant.u0, variant.v0, variant.u1, variant.v1, variant.layer, 0xffffffff, {handleLow, handleHigh}};
+    }
+}
+
+void InstanceRenderer::draw(GlState &state, FrameStats &stats)
+{
+    mBatch.flush(state, stats);
+}
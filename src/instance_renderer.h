@@ -0,0 +1,71 @@
+#ifndef INSTANCE_RENDERER_H
+#define INSTANCE_RENDERER_H
+
+#include "app_gl.h"
+#include "atlas.h"
+#include "damage.h"
+#include "gl_state.h"
+#include "logos.h"
+#include "program_cache.h"
+#include "sprite_batch.h"
+#include "stats.h"
+#include "util.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Draws every logo through a SpriteBatch. Logo images come from atlas pages
+ * (one instanced draw per page), from the layers of a single texture array,
+ * or from one texture per image addressed by bindless handles (one draw in
+ * total for either). Images must be premultiplied. A logo shows image
+ * id % images. On GLES the programs come from the instanced_es_* shaders;
+ * bindless is desktop only.
+ */
+class InstanceRenderer {
+public:
+    ~InstanceRenderer();
+
+    /* The programs init(), initArray() and initBindless() build, so they can be prepared early. */
+    static ProgramDesc atlasProgram();
+    static ProgramDesc arrayProgram();
+    static ProgramDesc bindlessProgram();
+
+    void init(ProgramCache &programs, std::size_t capacity, const Atlas &atlas, const std::vector<GLuint> &pages);
+    void initArray(ProgramCache &programs, std::size_t capacity, GLuint arrayTexture, std::size_t layers, int width, int height);
+    /* Needs GL_ARB_bindless_texture; the textures must outlive destroy(). */
+    void initBindless(ProgramCache &programs, std::size_t capacity, const std::vector<GLuint> &textures, const std::vector<Image> &images);
+    void destroy();
+
+    /* Multiplies every logo's drawn size; 1 draws images at their own size. */
+    void setScale(float scale);
+
+    /* Writes the frame's instances into the batch, waiting if the GPU is a full
+     * ring behind. Also marks every logo's rectangle in damage, when given. */
+    void update(const Logos &logos, FrameStats &stats, DamageTracker *damage = nullptr);
+    void draw(GlState &state, FrameStats &stats);
+
+private:
+    GLuint mProgram {GL_NONE};
+    SpriteBatch mBatch;
+    std::uint16_t mBatchProgram {0};
+    float mScale {1.0f};
+
+    struct Variant {
+        std::uint16_t texture;
+        float width;
+        float height;
+        float layer;
+        float u0;
+        float v0;
+        float u1;
+        float v1;
+        GLuint64 handle;
+    };
+    std::vector<Variant> mVariants;
+    std::vector<GLuint64> mResidentHandles;
+};
+
+#endif    // INSTANCE_RENDERER_H
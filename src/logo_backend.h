@@ -0,0 +1,31 @@
+#ifndef LOGO_BACKEND_H
+#define LOGO_BACKEND_H
+
+#include "logos.h"
+#include "stats.h"
+#include "util.h"
+
+#include <vector>
+
+/*
+ * A renderer that owns its own presentation, for the paths that do not go
+ * through the GL context in App: the software rasterizer and Vulkan. Each
+ * backend's init() takes the window (null when headless) and frame size.
+ */
+class LogoBackend {
+public:
+    virtual ~LogoBackend() = default;
+
+    /* A logo shows image id % images. */
+    virtual void setImages(const std::vector<Image> &images) = 0;
+    /* Multiplies every logo's drawn size; 1 draws images at their own size. */
+    virtual void setScale(float scale) = 0;
+
+    /* Draws the logos over the clear colour and presents the frame. */
+    virtual void drawFrame(const Logos &logos, FrameStats &stats) = 0;
+
+    /* RGBA8, top row first; the frame drawFrame() produced last. */
+    virtual Image capture() = 0;
+};
+
+#endif    // LOGO_BACKEND_H
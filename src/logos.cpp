@@ -0,0 +1,79 @@
+#include "logos.h"
+
+#include <cmath>
+#include <cstdlib>
+
+Bounds logoBounds(int arenaWidth, int arenaHeight, int logoWidth, int logoHeight)
+{
+    Bounds bounds;
+    bounds.minX = static_cast<float>(logoWidth / 2);
+    bounds.maxX = static_cast<float>(arenaWidth - logoWidth / 2);
+    bounds.minY = static_cast<float>(logoHeight / 2);
+    bounds.maxY = static_cast<float>(arenaHeight - logoHeight / 2 - 5);
+    return bounds;
+}
+
+void Logos::resize(std::size_t count)
+{
+    x.resize(count);
+    y.resize(count);
+    vx.resize(count);
+    vy.resize(count);
+    id.resize(count);
+}
+
+static float randomRange(float min, float max)
+{
+    return min + (max - min) * (static_cast<float>(rand()) / static_cast<float>(RAND_MAX));
+}
+
+void spawnLogos(Logos &logos, std::size_t count, const Bounds &bounds)
+{
+    logos.resize(count);
+
+    for (std::size_t i = 0; i < count; i++) {
+        float initialXVec = 0.2f + static_cast<float>(rand() % 10) / 8.0f;
+        float initialYVec = 0.2f + static_cast<float>(rand() % 10) / 8.0f;
+        float length = std::sqrt(initialXVec * initialXVec + initialYVec * initialYVec);
+
+        logos.id[i] = static_cast<std::uint32_t>(i);
+        logos.vx[i] = initialXVec / length;
+        logos.vy[i] = initialYVec / length;
+
+        // The first logo starts in the middle, like the single-logo screensaver did.
+        if (i == 0) {
+            logos.x[i] = (bounds.minX + bounds.maxX) / 2.0f;
+            logos.y[i] = (bounds.minY + bounds.maxY) / 2.0f;
+        }
+        else {
+            logos.x[i] = randomRange(bounds.minX, bounds.maxX);
+            logos.y[i] = randomRange(bounds.minY, bounds.maxY);
+        }
+    }
+}
+
+void stepLogos(Logos &logos, const Bounds &bounds, float speed)
+{
+    const std::size_t count = logos.size();
+    float *x = logos.x.data();
+    float *y = logos.y.data();
+    float *vx = logos.vx.data();
+    float *vy = logos.vy.data();
+
+    // Reflections force the sign instead of negating, so a logo pushed past an
+    // edge (e.g. by the arrow keys) heads back in rather than jittering there.
+    // Keep in sync with simulate.glsl.
+    for (std::size_t i = 0; i < count; i++) {
+        x[i] += vx[i] * speed;
+        y[i] += vy[i] * speed;
+
+        if (x[i] >= bounds.maxX)
+            vx[i] = -std::fabs(vx[i]);
+        if (x[i] <= bounds.minX)
+            vx[i] = std::fabs(vx[i]);
+        if (y[i] >= bounds.maxY)
+            vy[i] = -std::fabs(vy[i]);
+        if (y[i] <= bounds.minY)
+            vy[i] = std::fabs(vy[i]);
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef LOGOS_H
+#define LOGOS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* Range a logo's centre may occupy before it bounces. */
+struct Bounds {
+    float minX {0.0f};
+    float maxX {0.0f};
+    float minY {0.0f};
+    float maxY {0.0f};
+};
+
+Bounds logoBounds(int arenaWidth, int arenaHeight, int logoWidth, int logoHeight);
+
+/* Simulation state, one entry per logo in each array. */
+struct Logos {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> vx;
+    std::vector<float> vy;
+    /* Stable identity, e.g. to pick the logo's image; survives re-sorting. */
+    std::vector<std::uint32_t> id;
+
+    std::size_t size() const
+    {
+        return x.size();
+    }
+
+    void resize(std::size_t count);
+};
+
+void spawnLogos(Logos &logos, std::size_t count, const Bounds &bounds);
+
+/* Advance every logo by one tick and reflect velocities off the bounds. */
+void stepLogos(Logos &logos, const Bounds &bounds, float speed);
+
+#endif    // LOGOS_H
@@ -1,9 +1,16 @@
 #include "app_gl.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <ctime>
+#include <filesystem>
+#include <memory>
 #include <string>
 #include <stdexcept>
 #include <iostream>
+#include <thread>
 #include <vector>
 
 #define SDL_MAIN_HANDLED
@@ -17,31 +24,77 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "atlas.h"
+#include "damage.h"
+#include "feedback_sim.h"
+#include "gl_state.h"
+#include "headless.h"
+#include "instance_renderer.h"
+#include "logo_backend.h"
+#include "logo_blocks.h"
+#include "logos.h"
+#include "mipmap.h"
+#include "morton.h"
+#include "options.h"
+#include "packed_logos.h"
+#include "pass_timer.h"
+#include "program_cache.h"
+#include "present.h"
+#include "program.h"
+#include "soft_backend.h"
+#include "stats.h"
+#include "trails.h"
 #include "util.h"
+#include "vulkan_backend.h"
 
 static constexpr int kWindowWidth {800};
 static constexpr int kWindowHeight {600};
+// Steering speed of the first logo, in pixels per frame.
 static constexpr float kMoveSpeed {4.0f};
+// Simulation ticks per second, and the most ticks low-power mode will fold
+// into one presented frame.
+static constexpr int kTickRate {60};
+static constexpr int kMaxTicksPerFrame {30};
+// Lanes per block for --sim=blocks: each field of a block fills one cache line.
+static constexpr std::size_t kBlockLanes {16};
+// glClearColor(0.3, 0.1, 0.1, 1) as RGBA8, red in the lowest byte.
+static constexpr std::uint32_t kBackendClearColour {0xff1a1a4c};
 
 struct Object {
-    GLuint texture;
-    GLuint vao;
-    GLuint vbo;
+    GLuint texture {GL_NONE};
+    GLuint vao {GL_NONE};
+    GLuint vbo {GL_NONE};
+    GLint modelLocation {-1};
     glm::vec3 pos {0.0f, 0.0f, 0.0f};
     glm::vec3 rot;
     glm::mat4 model {1.0f};
     glm::vec2 velocity;
     int width;
     int height;
+    /* GL 3.3 has no storage buffers; positions come in as a per-instance attribute instead. */
+    bool positionAttribute {false};
 
-    void render(GLuint program)
+    void render(GlState &state)
     {
-        glBindVertexArray(vao);
-        glUniform1i(glGetUniformLocation(program, "tex"), 0);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glUniformMatrix4fv(glGetUniformLocation(program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glDrawArrays(GL_POINTS, 0, 1);
+        renderFrom(state, vbo, 1);
+    }
+
+    /* Draws count quads centred on the vec4 positions in buffer. */
+    void renderFrom(GlState &state, GLuint buffer, GLsizei count)
+    {
+        state.bindVertexArray(vao);
+        state.activeTexture(GL_TEXTURE0 + kLogoTextureUnit);
+        state.bindTexture(GL_TEXTURE_2D, texture);
+        if (positionAttribute) {
+            // The feedback backend swaps buffers every tick, so the pointer
+            // is set per draw.
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            glVertexAttribPointer(kLogoPositionLocation, 2, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 4, nullptr);
+        }
+        else
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kSpriteBufferBinding, buffer);
+        glUniformMatrix4fv(modelLocation, 1, GL_FALSE, glm::value_ptr(model));
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
     }
 
     void updateTransform()
@@ -67,28 +120,53 @@ struct Object {
 
 class App {
 public:
-    App(const std::string &windowTitle, int windowWidth, int windowHeight);
+    App(const std::string &windowTitle, int windowWidth, int windowHeight, const Options &options);
     ~App();
 
     void createWindow(const std::string &windowTitle, int windowWidth, int windowHeight);
     void cleanup();
 
+    void handleEvent(const SDL_Event &ev);
     void events();
+    /* Sleeps until the next low-power frame is due, handling events meanwhile. */
+    void waitForFrame();
+    void steer();
     void update();
+    void resort();
+    void markDamage();
     void render();
     void run();
 
     void init();
+    void initSimulation();
+    void initBackend();
+    void renderBackend();
+    void prepareShaders();
+    void waitForShaders();
+    void presentPlaceholder();
 
     void keyDown(SDL_Keycode key);
 
     void recalculateCamera();
 
 private:
+    Options mOptions;
+
     SDL_Window *mWindow {nullptr};
     SDL_GLContext mContext {nullptr};
+    /* The context is GLES 3.1, which only runs the instanced renderer. */
+    bool mGles {false};
+    /* The context is desktop GL below 4.5, which only runs the feedback backend. */
+    bool mLegacyGl {false};
+    HeadlessContext mHeadless;
+    /* The software or Vulkan renderer; these need no GL context. */
+    std::unique_ptr<LogoBackend> mBackend;
+    std::size_t mFrame {0};
     bool mShouldClose {false};
     bool mDoneInit{false};
+    bool mSuspended {false};
+    std::chrono::steady_clock::time_point mNextFrame;
+    std::chrono::steady_clock::duration mFrameInterval {};
 
     const Uint8 *mKeys {nullptr};
 
@@ -97,12 +175,68 @@ private:
     glm::mat4 mView;
     glm::mat4 mProjection;
 
+    GlState mState;
+    ProgramCache mPrograms;
     Object mLogo;
-
-    GLuint mProgram;
+    Logos mLogos;
+    Bounds mBounds;
+    FeedbackSim mFeedback;
+    PackedLogos mPacked;
+    LogoBlocks<kBlockLanes> mBlocks;
+    InstanceRenderer mInstanceRenderer;
+    FrameStats mFrameStats;
+    StatsReporter mStatsReporter;
+    PassTimer mPassTimer;
+    CpuUsageReporter mCpuReporter;
+    TrailBuffer mTrails;
+    DamageTracker mDamage;
+    DamagePresenter mPresenter;
+    std::vector<DamageRect> mDamageRects;
+    std::vector<DamageRect> mSwapRects;
+    MortonSorter mSorter;
+    std::size_t mTicks {0};
+
+    GLuint mProgram {GL_NONE};
+    std::vector<GLuint> mLogoTextures;
+    GLuint mCameraUbo {GL_NONE};
+    GLuint mTrailProgram {GL_NONE};
+    GLint mTrailHeadLocation {-1};
+    GLuint mTrailVbo {GL_NONE};
+    GLuint mTrailVao {GL_NONE};
 };
 
-App::App(const std::string &windowTitle, int windowWidth, int windowHeight)
+static ProgramDesc objectProgram(bool legacy)
+{
+    if (legacy)
+        return {{{GL_VERTEX_SHADER, "gl33_vert.glsl"}, {GL_FRAGMENT_SHADER, "gl33_frag.glsl"}}};
+    return {{{GL_VERTEX_SHADER, "vert.glsl"}, {GL_FRAGMENT_SHADER, "frag.glsl"}}};
+}
+
+static ProgramDesc trailProgram()
+{
+    return {{{GL_VERTEX_SHADER, "trail_vert.glsl"}, {GL_FRAGMENT_SHADER, "trail_frag.glsl"}}};
+}
+
+/* Every PNG in dir, in name order, or just the default logo. */
+static std::vector<std::string> logoImagePaths(const std::string &dir)
+{
+    if (dir.empty())
+        return {"logo.png"};
+
+    std::vector<std::string> paths;
+    for (const auto &entry : std::filesystem::directory_iterator(dir)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".png")
+            paths.push_back(entry.path().string());
+    }
+    std::sort(paths.begin(), paths.end());
+
+    if (paths.empty())
+        throw std::runtime_error("No .png logos found in " + dir);
+    return paths;
+}
+
+App::App(const std::string &windowTitle, int windowWidth, int windowHeight, const Options &options)
+    : mOptions(options)
 {
     createWindow(windowTitle, windowWidth, windowHeight);
     init();
@@ -116,15 +250,31 @@ App::~App()
 
 void App::cleanup()
 {
-    if (mContext)
+    if (mContext || mHeadless.active())
     {
-        SDL_GL_DeleteContext(mContext);
+        mFeedback.destroy();
+        mInstanceRenderer.destroy();
+        mPassTimer.destroy();
+        mPrograms.destroy();
+        glDeleteTextures(static_cast<GLsizei>(mLogoTextures.size()), mLogoTextures.data());
+        mLogoTextures.clear();
         glDeleteProgram(mProgram);
+        glDeleteBuffers(1, &mCameraUbo);
+        glDeleteProgram(mTrailProgram);
+        glDeleteBuffers(1, &mTrailVbo);
+        glDeleteVertexArrays(1, &mTrailVao);
         glDeleteBuffers(1, &mLogo.vbo);
         glDeleteVertexArrays(1, &mLogo.vao);
         glDeleteTextures(1, &mLogo.texture);
+        if (mContext)
+            SDL_GL_DeleteContext(mContext);
+        mContext = nullptr;
+        mHeadless.destroy();
     }
 
+    // Backends present to the window, so they go before it.
+    mBackend.reset();
+
     if (mDoneInit)
     {
         if (mWindow)
@@ -137,15 +287,58 @@ void App::createWindow(const std::string &windowTitle, int windowWidth, int wind
 {
     cleanup();
 
+    const bool software = mOptions.render == RenderPath::Software;
+    const bool vulkan = mOptions.render == RenderPath::Vulkan;
+    if (mOptions.headless) {
+        if (!software && !vulkan)
+            mHeadless.init(windowWidth, windowHeight, mOptions.gles);
+        return;
+    }
+
+    // Buffer age and swap-with-damage are EGL extensions; SDL picks GLX on
+    // X11 unless told otherwise.
+    if (mOptions.damage)
+        SDL_SetHint(SDL_HINT_VIDEO_X11_FORCE_EGL, "1");
+
     SDL_Init(SDL_INIT_VIDEO);
     mDoneInit = true;
 
-    mWindow = SDL_CreateWindow(windowTitle.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, windowWidth, windowHeight, SDL_WINDOW_OPENGL);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 6);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    // The backends set up their own presentation in initBackend().
+    if (software || vulkan) {
+        mWindow = SDL_CreateWindow(windowTitle.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, windowWidth, windowHeight, vulkan ? SDL_WINDOW_VULKAN : 0);
+        if (!mWindow)
+            throw std::runtime_error(std::string("Failed to make SDL window: ") + SDL_GetError());
+        return;
+    }
 
-    mContext = SDL_GL_CreateContext(mWindow);
+    // Desktop GL 4.6 first, then 3.3 core, which still runs the feedback
+    // backend, then GLES 3.1 for clients that only have that. SDL picks its
+    // GL library when the window is created, so a different API needs a new
+    // window. Everything is a 2D sprite drawn in order, so none asks for a
+    // depth buffer.
+    SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 0);
+    if (!mOptions.gles) {
+        const int versions[][2] {{4, 6}, {3, 3}};
+        for (const int *version : versions) {
+            mWindow = SDL_CreateWindow(windowTitle.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, windowWidth, windowHeight, SDL_WINDOW_OPENGL);
+            SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, version[0]);
+            SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, version[1]);
+            SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+            mContext = SDL_GL_CreateContext(mWindow);
+            if (mContext)
+                break;
+            SDL_DestroyWindow(mWindow);
+            mWindow = nullptr;
+        }
+    }
+
+    if (!mContext) {
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 1);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_ES);
+        mWindow = SDL_CreateWindow(windowTitle.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, windowWidth, windowHeight, SDL_WINDOW_OPENGL);
+        mContext = SDL_GL_CreateContext(mWindow);
+    }
 
     if (!mContext) {
         throw std::runtime_error(std::string("Failed to make SDL GL context: ") + SDL_GetError());
@@ -154,58 +347,305 @@ void App::createWindow(const std::string &windowTitle, int windowWidth, int wind
     SDL_GL_SetSwapInterval(1);
     SDL_GL_MakeCurrent(mWindow, mContext);
 
+    // GLEW's GLX half fails when SDL went through EGL (GLES, or --damage),
+    // though every GL entry point was loaded.
     glewExperimental = true;
     int err = glewInit();
-    if (err != GLEW_OK) {
+    if (err != GLEW_OK && err != GLEW_ERROR_NO_GLX_DISPLAY) {
         throw std::runtime_error(std::string("Failed to load GL: ") + reinterpret_cast<const char*>(glewGetErrorString(err)));
     }
+
+    if (mOptions.damage) {
+        mPresenter.init();
+        mDamage.init(windowWidth, windowHeight);
+    }
+}
+
+void App::initSimulation()
+{
+    mBounds = logoBounds(kWindowWidth, kWindowHeight, mLogo.width, mLogo.height);
+    spawnLogos(mLogos, mOptions.logoCount, mBounds);
+
+    if (mOptions.sim == SimBackend::Feedback) {
+        mFeedback.init(mPrograms, mLogos, mState, mOptions.trailLength > 0);
+    }
+    else if (mOptions.sim == SimBackend::Packed) {
+        mPacked.init(kWindowWidth, kWindowHeight, mOptions.speed);
+        mPacked.pack(mLogos);
+    }
+    else if (mOptions.sim == SimBackend::Blocks) {
+        mBlocks.assign(mLogos);
+    }
+    else if (mOptions.resortInterval > 0)
+        mSorter.init(mLogos.size(), 0, mOptions.stats);
+}
+
+void App::initBackend()
+{
+    // The steering and bounce bounds still follow the default logo.
+    const Image logo = loadImage("logo.png");
+    mLogo.width = logo.width;
+    mLogo.height = logo.height;
+
+    initSimulation();
+
+    std::vector<Image> images;
+    for (const std::string &path : logoImagePaths(mOptions.logoDir))
+        images.push_back(loadImage(path));
+
+    if (mOptions.render == RenderPath::Vulkan) {
+        auto vulkan = std::make_unique<VulkanBackend>();
+        vulkan->init(mWindow, kWindowWidth, kWindowHeight, mLogos.size(), kBackendClearColour);
+        mBackend = std::move(vulkan);
+    }
+    else {
+        auto software = std::make_unique<SoftBackend>();
+        software->init(mWindow, kWindowWidth, kWindowHeight, kBackendClearColour);
+        mBackend = std::move(software);
+    }
+    mBackend->setImages(images);
+    mBackend->setScale(mOptions.logoScale);
+
+    mKeys = SDL_GetKeyboardState(nullptr);
 }
 
 void App::init()
 {
+    if (mOptions.render == RenderPath::Software || mOptions.render == RenderPath::Vulkan) {
+        initBackend();
+        return;
+    }
+
+    mGles = glIsEs();
+    mLegacyGl = glIsLegacy();
+    if (mGles && (mOptions.render != RenderPath::Instanced || mOptions.sim == SimBackend::Feedback || mOptions.trailLength > 0))
+        throw std::runtime_error("Only GLES 3.1 is available, which needs --render=instanced, a CPU simulation backend and no trails");
+    if (mLegacyGl && (mOptions.sim != SimBackend::Feedback || mOptions.trailLength > 0))
+        throw std::runtime_error(std::string("Only GL ") + reinterpret_cast<const char *>(glGetString(GL_VERSION)) + " is available, which needs --sim=feedback and no trails");
+    if (mOptions.stats) {
+        std::cout << "context: " << glGetString(GL_VERSION) << ", " << glGetString(GL_RENDERER) << std::endl;
+        mPassTimer.init();
+        if (!mPassTimer.gpuSupported())
+            std::cout << "timer queries unavailable, reporting CPU pass times only" << std::endl;
+    }
+
+    mPrograms.init(mOptions.programCacheDir, mOptions.stats);
+
     glClearColor(0.3f, 0.1f, 0.1f, 1.0f);
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    mState.setValidation(mOptions.validateGlState);
+    // Textures are premultiplied at load, see loadTexture().
+    mState.enable(GL_BLEND);
+    mState.blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
     mKeys = SDL_GetKeyboardState(nullptr);
 
     /* VIEW */
+    // Every program reads the camera from this block, bound once here and
+    // only rewritten by recalculateCamera().
+    if (mGles || mLegacyGl) {
+        glGenBuffers(1, &mCameraUbo);
+        glBindBuffer(GL_UNIFORM_BUFFER, mCameraUbo);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlock), nullptr, GL_DYNAMIC_DRAW);
+    }
+    else {
+        glCreateBuffers(1, &mCameraUbo);
+        glNamedBufferStorage(mCameraUbo, sizeof(CameraBlock), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    }
+    glBindBufferBase(GL_UNIFORM_BUFFER, kCameraBinding, mCameraUbo);
+
     mCameraEye = glm::vec3(0.0f, 0.0f, 3.0f);
     mCameraTarget = glm::vec3(0.0f, 0.0f, -1.0f);
-    mView = glm::lookAt(mCameraEye, mCameraEye + mCameraTarget, glm::vec3(0.0f, 1.0f, 0.0f));
-    mProjection = glm::ortho(0.0f, static_cast<float>(kWindowWidth), static_cast<float>(kWindowHeight), 0.0f, 0.1f, 500.0f);
+    recalculateCamera();
+
+    // Start every compile now and put something on screen while the
+    // driver works; the loading below needs no programs.
+    prepareShaders();
+    presentPlaceholder();
+
+    /* OBJECT & GEOMETRY */
+    mLogo.texture = loadTexture("logo.png", mLogo.width, mLogo.height, mOptions.mipCacheDir);
+    mLogo.model = glm::mat4(1.0f);
+
+    // The feedback backend draws straight from its own buffers instead.
+    const bool instancedLogos = mOptions.render == RenderPath::Instanced && mOptions.sim != SimBackend::Feedback;
+    auto decodeStart = std::chrono::steady_clock::now();
+    std::vector<Image> images;
+    if (instancedLogos) {
+        for (const std::string &path : logoImagePaths(mOptions.logoDir)) {
+            images.push_back(loadImage(path));
+            premultiplyAlpha(images.back());
+        }
+    }
+    const double decodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - decodeStart).count();
 
     /* SHADERS */
-    mProgram = glCreateProgram();
+    waitForShaders();
+
+    // GLES only draws through the instanced renderer's own programs. GL 3.3
+    // has no binding qualifiers or glProgramUniform, so those are set here.
+    if (mLegacyGl) {
+        mProgram = mPrograms.build(objectProgram(true));
+
+        ProgramReflection reflection;
+        reflection.reflect(mProgram);
+        mLogo.modelLocation = reflection.location("model");
+        mState.useProgram(mProgram);
+        glUniform2f(reflection.location("size"), static_cast<float>(mLogo.width), static_cast<float>(mLogo.height));
+        glUniform1i(reflection.location("tex"), static_cast<GLint>(kLogoTextureUnit));
+        glUniformBlockBinding(mProgram, glGetUniformBlockIndex(mProgram, "Camera"), kCameraBinding);
+
+        // renderFrom() points the attribute at whichever feedback buffer is current.
+        glGenVertexArrays(1, &mLogo.vao);
+        mState.bindVertexArray(mLogo.vao);
+        glEnableVertexAttribArray(kLogoPositionLocation);
+        glVertexAttribDivisor(kLogoPositionLocation, 1);
+        mState.bindVertexArray(GL_NONE);
+        mLogo.positionAttribute = true;
+    }
+    else if (!mGles) {
+        mProgram = mPrograms.build(objectProgram(false));
+
+        ProgramReflection reflection;
+        reflection.reflect(mProgram);
+        mLogo.modelLocation = reflection.location("model");
+        glProgramUniform2f(mProgram, reflection.location("size"), static_cast<float>(mLogo.width), static_cast<float>(mLogo.height));
+
+        // A single logo at the origin, moved by the model matrix. Quads are
+        // built from gl_VertexID, so the vertex array carries no attributes.
+        std::vector<GLfloat> vertices = {0.0f, 0.0f, 0.0f, 0.0f};
+        glCreateBuffers(1, &mLogo.vbo);
+        glNamedBufferStorage(mLogo.vbo, vertices.size() * sizeof(GLfloat), vertices.data(), 0);
+        glCreateVertexArrays(1, &mLogo.vao);
+    }
 
-    GLuint vertexShader = loadShader("vert.glsl", GL_VERTEX_SHADER);
-    GLuint fragmentShader = loadShader("frag.glsl", GL_FRAGMENT_SHADER);
+    /* SIMULATION */
+    initSimulation();
+
+    if (instancedLogos) {
+        auto start = std::chrono::steady_clock::now();
+
+        // Bindless needs driver support; texture arrays need one size for
+        // every layer and a bounded layer count. Without bindless try the
+        // array, and fall back to atlases from there.
+        const bool useBindless = mOptions.textures == TextureMode::Bindless && GLEW_ARB_bindless_texture && !mGles;
+        if (mOptions.textures == TextureMode::Bindless && !useBindless)
+            std::cerr << "GL_ARB_bindless_texture unavailable, falling back" << std::endl;
+
+        GLint maxLayers = 0;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+        bool useArray = !useBindless && mOptions.textures != TextureMode::Atlas && images.size() <= static_cast<std::size_t>(maxLayers);
+        for (const Image &image : images)
+            useArray = useArray && image.width == images.front().width && image.height == images.front().height;
+
+        if (useBindless) {
+            for (const Image &image : images)
+                mLogoTextures.push_back(createMipmappedTexture(loadMipChain(image, mOptions.mipCacheDir)));
+            mInstanceRenderer.initBindless(mPrograms, mLogos.size(), mLogoTextures, images);
+        }
+        else if (useArray) {
+            mLogoTextures.push_back(createTextureArray(images));
+            mInstanceRenderer.initArray(mPrograms, mLogos.size(), mLogoTextures.front(), images.size(), images.front().width, images.front().height);
+        }
+        else {
+            GLint maxTextureSize = 0;
+            glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+            Atlas atlas = packAtlas(images, std::min(kAtlasMaxPageSize, static_cast<int>(maxTextureSize)), kAtlasPadding);
+            mLogoTextures = uploadAtlas(atlas, mOptions.mipCacheDir);
+            mInstanceRenderer.init(mPrograms, mLogos.size(), atlas, mLogoTextures);
+        }
+        mInstanceRenderer.setScale(mOptions.logoScale);
 
-    glAttachShader(mProgram, vertexShader);
-    glAttachShader(mProgram, fragmentShader);
-    linkProgram(mProgram);
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+        if (mOptions.stats) {
+            std::cout << "logo textures: " << images.size() << " images in " << mLogoTextures.size()
+                      << (useBindless ? " bindless textures, " : useArray ? " texture array, " : " atlas pages, ")
+                      << decodeMs + std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+        }
+    }
 
-    /* OBJECT & GEOMETRY */
-    mLogo.texture = loadTexture("logo.png", mLogo.width, mLogo.height);
-    glPointSize(static_cast<float>(std::max(mLogo.width, mLogo.height)));
-    std::vector<GLfloat> vertices = {0.0f, 0.0f};
-    glCreateBuffers(1, &mLogo.vbo);
-    glNamedBufferStorage(mLogo.vbo, vertices.size(), vertices.data(), 0);
-    glCreateVertexArrays(1, &mLogo.vao);
-    glVertexArrayVertexBuffer(mLogo.vao, 0, mLogo.vbo, 0, sizeof(GLfloat) * 2);
-    glEnableVertexArrayAttrib(mLogo.vao, 0);
-    glVertexArrayAttribFormat(mLogo.vao, 0, 2, GL_FLOAT, GL_FALSE, 0);
-    glVertexArrayAttribBinding(mLogo.vao, 0, 0);
-    mLogo.model = glm::mat4(1.0f);
+    /* TRAILS */
+    if (mOptions.trailLength > 0) {
+        mTrails.init(mLogos.size(), mOptions.trailLength);
+
+        mTrailProgram = mPrograms.build(trailProgram());
+
+        ProgramReflection trailReflection;
+        trailReflection.reflect(mTrailProgram);
+        mTrailHeadLocation = trailReflection.location("head");
+        glProgramUniform1i(mTrailProgram, trailReflection.location("trailLength"), static_cast<GLint>(mTrails.length()));
+        glProgramUniform1i(mTrailProgram, trailReflection.location("logoCount"), static_cast<GLint>(mTrails.logoCount()));
+        glProgramUniform2f(mTrailProgram, trailReflection.location("size"), static_cast<float>(mLogo.width), static_cast<float>(mLogo.height));
+
+        glCreateBuffers(1, &mTrailVbo);
+        glNamedBufferStorage(mTrailVbo, mTrails.sizeBytes(), mTrails.data(), GL_DYNAMIC_STORAGE_BIT);
+        glCreateVertexArrays(1, &mTrailVao);
+    }
+
+    // GLES and GL 3.3 uploads and vertex array setup go through plain binds.
+    mState.invalidate();
+}
+
+void App::prepareShaders()
+{
+    // Which instanced variant gets used depends on the images, so every
+    // candidate is started; the cache deletes the ones never built.
+    if (!mGles)
+        mPrograms.prepare(objectProgram(mLegacyGl));
+    if (mOptions.sim == SimBackend::Feedback)
+        mPrograms.prepare(FeedbackSim::programDesc(mOptions.trailLength > 0));
+    if (mOptions.render == RenderPath::Instanced && mOptions.sim != SimBackend::Feedback) {
+        mPrograms.prepare(InstanceRenderer::atlasProgram());
+        if (mOptions.textures != TextureMode::Atlas)
+            mPrograms.prepare(InstanceRenderer::arrayProgram());
+        if (mOptions.textures == TextureMode::Bindless && GLEW_ARB_bindless_texture && !mGles)
+            mPrograms.prepare(InstanceRenderer::bindlessProgram());
+    }
+    if (mOptions.trailLength > 0)
+        mPrograms.prepare(trailProgram());
+}
+
+void App::waitForShaders()
+{
+    auto start = std::chrono::steady_clock::now();
+    std::size_t frames = 0;
+    while (!mPrograms.ready()) {
+        presentPlaceholder();
+        frames++;
+    }
+
+    if (mOptions.stats) {
+        std::cout << "shaders: " << (mPrograms.parallel() ? "parallel" : "serial") << " compile, waited "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+                  << " ms over " << frames << " placeholder frames" << std::endl;
+    }
+}
 
-    float initialXVec = 0.2f + static_cast<float>(rand() % 10) / 8.0f;
-    float initialYVec = 0.2f + static_cast<float>(rand() % 10) / 8.0f;
+void App::presentPlaceholder()
+{
+    // Just the clear colour, so the window shows something other than
+    // garbage while the logos are not ready.
+    glClear(GL_COLOR_BUFFER_BIT);
+    if (mOptions.headless) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return;
+    }
+    SDL_GL_SwapWindow(mWindow);
+    events();
+}
+
+void App::recalculateCamera()
+{
+    mView = glm::lookAt(mCameraEye, mCameraEye + mCameraTarget, glm::vec3(0.0f, 1.0f, 0.0f));
+    mProjection = glm::ortho(0.0f, static_cast<float>(kWindowWidth), static_cast<float>(kWindowHeight), 0.0f, 0.1f, 500.0f);
 
-    mLogo.setVector(glm::normalize(glm::vec3 {initialXVec, initialYVec, 0.0f}));
-    mLogo.setPosition({400.0f, 300.0f, 0.0f});
+    CameraBlock camera;
+    std::memcpy(camera.view, glm::value_ptr(mView), sizeof(camera.view));
+    std::memcpy(camera.projection, glm::value_ptr(mProjection), sizeof(camera.projection));
+    if (mGles || mLegacyGl) {
+        glBindBuffer(GL_UNIFORM_BUFFER, mCameraUbo);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(camera), &camera);
+    }
+    else
+        glNamedBufferSubData(mCameraUbo, 0, sizeof(camera), &camera);
 }
 
 void App::keyDown(SDL_Keycode key)
@@ -219,22 +659,84 @@ void App::keyDown(SDL_Keycode key)
     }
 }
 
-void App::events()
+void App::handleEvent(const SDL_Event &ev)
 {
+    switch (ev.type) {
+        case SDL_QUIT:
+            mShouldClose = true;
+            break;
+        case SDL_KEYDOWN:
+            keyDown(ev.key.keysym.sym);
+            break;
+        case SDL_WINDOWEVENT:
+            // SDL2 has no occlusion event; hidden and minimized are as close
+            // as it gets.
+            switch (ev.window.event) {
+                case SDL_WINDOWEVENT_HIDDEN:
+                case SDL_WINDOWEVENT_MINIMIZED:
+                    mSuspended = true;
+                    break;
+                case SDL_WINDOWEVENT_SHOWN:
+                case SDL_WINDOWEVENT_RESTORED:
+                case SDL_WINDOWEVENT_EXPOSED:
+                    mSuspended = false;
+                    break;
+                default:
+                    break;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void App::waitForFrame()
+{
+    using Clock = std::chrono::steady_clock;
+
     SDL_Event ev;
-    while (SDL_PollEvent(&ev)) {
-        switch (ev.type) {
-            case SDL_QUIT:
-                mShouldClose = true;
-                break;
-            case SDL_KEYDOWN:
-                keyDown(ev.key.keysym.sym);
-                break;
-            default:
-                break;
+    while (!mShouldClose) {
+        // Nothing is drawn while hidden, so block until something happens.
+        if (mSuspended) {
+            if (SDL_WaitEvent(&ev))
+                handleEvent(ev);
+            mNextFrame = Clock::now();
+            continue;
         }
+
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(mNextFrame - Clock::now()).count();
+        if (remaining <= 0)
+            break;
+        if (SDL_WaitEventTimeout(&ev, static_cast<int>(remaining)))
+            handleEvent(ev);
     }
 
+    while (SDL_PollEvent(&ev))
+        handleEvent(ev);
+
+    // Skip frames that were missed rather than rushing to catch up.
+    mNextFrame = std::max(mNextFrame + mFrameInterval, Clock::now());
+}
+
+void App::events()
+{
+    SDL_Event ev;
+    while (SDL_PollEvent(&ev))
+        handleEvent(ev);
+}
+
+void App::steer()
+{
+    // The arrow keys steer the first logo; its state lives on the GPU with
+    // the feedback backend, so there is nothing to nudge there.
+    if (mOptions.sim != SimBackend::Cpu)
+        return;
+
+    // Sorting shuffles the arrays, so follow the first logo by its handle.
+    const std::size_t steered = mOptions.resortInterval > 0 ? mSorter.indexOf(0) : 0;
+
+    mLogo.setPosition({mLogos.x[steered], mLogos.y[steered], 0.0f});
+
     if (mKeys[SDL_SCANCODE_LEFT])
         mLogo.moveDir({-1.0f, 0.0f, 0.0f});
     if (mKeys[SDL_SCANCODE_RIGHT])
@@ -244,57 +746,243 @@ void App::events()
     if (mKeys[SDL_SCANCODE_DOWN])
         mLogo.moveDir({0.0f, 1.0f, 0.0f});
 
-    mLogo.pos.x = std::max(0.0f, std::min(mLogo.pos.x, static_cast<float>(kWindowWidth - mLogo.width / 2)));
-    mLogo.pos.y = std::max(0.0f, std::min(mLogo.pos.y, static_cast<float>(kWindowHeight - mLogo.height / 2)));
-
-    mLogo.updateTransform();
+    mLogos.x[steered] = std::max(0.0f, std::min(mLogo.pos.x, static_cast<float>(kWindowWidth - mLogo.width / 2)));
+    mLogos.y[steered] = std::max(0.0f, std::min(mLogo.pos.y, static_cast<float>(kWindowHeight - mLogo.height / 2)));
 }
 
 void App::update()
 {
-    auto vec = glm::vec4(mLogo.velocity, 0, 1);
+    switch (mOptions.sim) {
+        case SimBackend::Cpu:
+            stepLogos(mLogos, mBounds, mOptions.speed);
+            if (mOptions.resortInterval > 0 && ++mTicks % mOptions.resortInterval == 0)
+                resort();
+            break;
+        case SimBackend::Feedback:
+            // The step captures the positions for the trails straight into
+            // the next slot, so the state never comes back to the CPU.
+            mTrails.advance();
+            mFeedback.step(mBounds, mOptions.speed, mState, mTrailVbo, static_cast<GLintptr>(mTrails.head() * mTrails.logoCount() * sizeof(GLfloat) * 2));
+            break;
+        case SimBackend::Packed:
+            mPacked.step(mBounds);
+            // Trails sample every tick; otherwise render() unpacks just the
+            // ticks it shows.
+            if (mTrails.length() > 0)
+                mPacked.unpack(mLogos);
+            break;
+        case SimBackend::Blocks:
+            stepLogoBlocks(mBlocks, mBounds, mOptions.speed);
+            // As with packed, render() stores the ticks it shows.
+            if (mTrails.length() > 0)
+                mBlocks.store(mLogos);
+            break;
+    }
+
+    if (mTrails.length() > 0 && mOptions.sim != SimBackend::Feedback) {
+        mTrails.push(mLogos);
+
+        // Only the slot just written changed, and it is one contiguous run.
+        const GLsizeiptr slotBytes = static_cast<GLsizeiptr>(mTrails.logoCount() * sizeof(GLfloat) * 2);
+        glNamedBufferSubData(mTrailVbo, static_cast<GLintptr>(mTrails.head()) * slotBytes, slotBytes, mTrails.data() + mTrails.head() * mTrails.logoCount() * 2);
+    }
+}
+
+void App::resort()
+{
+    mSorter.sort(mLogos, mBounds, mTrails.length() > 0 ? &mTrails : nullptr);
 
-    mLogo.moveDir(vec);
+    // Every trail slot was permuted along with the logos.
+    if (mTrails.length() > 0)
+        glNamedBufferSubData(mTrailVbo, 0, static_cast<GLsizeiptr>(mTrails.sizeBytes()), mTrails.data());
 
-    if (mLogo.pos.x + (mLogo.width - 60) >= kWindowWidth)
-        vec.x = -vec.x;
-    if (mLogo.pos.x - (mLogo.width - 60) <= 0.0)
-        vec.x = -vec.x;
-    if (mLogo.pos.y + (mLogo.height / 2) + 5 >= kWindowHeight)
-        vec.y = -vec.y;
-    if (mLogo.pos.y - (mLogo.height / 2) <= 0.0)
-        vec.y = -vec.y;
+    // Reported with the frame these ticks lead up to.
+    const MortonStats &stats = mSorter.stats();
+    mFrameStats.resorts++;
+    mFrameStats.resortMs += stats.lastSortMs;
+    mFrameStats.neighbourSpread = stats.spreadAfter;
+}
 
-    mLogo.setVector(vec);
+void App::markDamage()
+{
+    // Trail samples fade a little more every frame, so all of them change.
+    const std::size_t trailSamples = mTrails.filled() * mTrails.logoCount();
+    for (std::size_t i = 0; i < trailSamples; i++)
+        mDamage.add(mTrails.data()[i * 2], mTrails.data()[i * 2 + 1], static_cast<float>(mLogo.width), static_cast<float>(mLogo.height));
+
+    // The instanced path marks its logos while building the batch.
+    if (mOptions.render == RenderPath::Objects) {
+        for (std::size_t i = 0; i < mLogos.size(); i++)
+            mDamage.add(mLogos.x[i], mLogos.y[i], static_cast<float>(mLogo.width), static_cast<float>(mLogo.height));
+    }
+}
+
+void App::renderBackend()
+{
+    mBackend->drawFrame(mLogos, mFrameStats);
+
+    if (!mOptions.screenshot.empty() && mFrame + 1 == mOptions.frames)
+        savePpm(mOptions.screenshot, mBackend->capture());
+    mFrame++;
+
+    if (mOptions.stats)
+        mStatsReporter.endFrame(mFrameStats);
+    mFrameStats.reset();
 }
 
 void App::render()
 {
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    if (mOptions.sim == SimBackend::Packed && mTrails.length() == 0)
+        mPacked.unpack(mLogos);
+    else if (mOptions.sim == SimBackend::Blocks && mTrails.length() == 0)
+        mBlocks.store(mLogos);
+
+    if (mBackend) {
+        renderBackend();
+        return;
+    }
 
-    glUseProgram(mProgram);
-    glUniformMatrix4fv(glGetUniformLocation(mProgram, "view"), 1, GL_FALSE, glm::value_ptr(mView));
-    glUniformMatrix4fv(glGetUniformLocation(mProgram, "projection"), 1, GL_FALSE, glm::value_ptr(mProjection));
-    mLogo.render(mProgram);
+    mPassTimer.beginFrame(mFrameStats);
+
+    // The buffer age has to be read before anything touches the back buffer.
+    const bool trackDamage = mOptions.damage && mOptions.sim != SimBackend::Feedback;
+    const int bufferAge = trackDamage ? mPresenter.bufferAge() : 0;
+
+    const bool instanced = mOptions.sim != SimBackend::Feedback && mOptions.render == RenderPath::Instanced;
+    auto submitStart = std::chrono::steady_clock::now();
+    if (instanced)
+        mInstanceRenderer.update(mLogos, mFrameStats, trackDamage ? &mDamage : nullptr);
+    if (trackDamage)
+        markDamage();
+
+    // Every sprite drawn this frame lies inside the damage, so only the
+    // clears need to be confined to it; the scissor box just lets the GPU
+    // skip the rest early.
+    const bool partial = trackDamage && mDamage.regions(bufferAge, mDamageRects);
+    if (!partial)
+        mDamageRects.clear();
+    mPresenter.setDamageRegion(mDamageRects);
+    // The compositor already has the last frame, so the swap only reports
+    // what moved since, however old or undefined the back buffer was.
+    if (!trackDamage || !mDamage.regions(1, mSwapRects))
+        mSwapRects.clear();
+
+    mPassTimer.beginPass(RenderPass::Clear, mFrameStats);
+    if (partial) {
+        int left = kWindowWidth, bottom = kWindowHeight, right = 0, top = 0;
+        mState.enable(GL_SCISSOR_TEST);
+        for (const DamageRect &rect : mDamageRects) {
+            glScissor(rect.x, rect.y, rect.width, rect.height);
+            glClear(GL_COLOR_BUFFER_BIT);
+            mFrameStats.redrawnPixels += static_cast<std::size_t>(rect.width) * rect.height;
+
+            left = std::min(left, rect.x);
+            bottom = std::min(bottom, rect.y);
+            right = std::max(right, rect.x + rect.width);
+            top = std::max(top, rect.y + rect.height);
+        }
+        glScissor(left, bottom, right - left, top - bottom);
+    }
+    else {
+        glClear(GL_COLOR_BUFFER_BIT);
+        mFrameStats.redrawnPixels = static_cast<std::size_t>(kWindowWidth) * kWindowHeight;
+    }
 
-    SDL_GL_SwapWindow(mWindow);
+    if (mTrails.filled() > 0) {
+        mPassTimer.beginPass(RenderPass::Trails, mFrameStats);
+        mState.useProgram(mTrailProgram);
+        glUniform1i(mTrailHeadLocation, static_cast<GLint>(mTrails.head()));
+        mState.bindVertexArray(mTrailVao);
+        mState.activeTexture(GL_TEXTURE0 + kLogoTextureUnit);
+        mState.bindTexture(GL_TEXTURE_2D, mLogo.texture);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kSpriteBufferBinding, mTrailVbo);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(mTrails.filled() * mTrails.logoCount()));
+        mFrameStats.drawCalls++;
+    }
+
+    mPassTimer.beginPass(RenderPass::Logos, mFrameStats);
+    if (mOptions.sim == SimBackend::Feedback) {
+        // Draw straight from the simulation's output buffer, which already
+        // holds positions in world space.
+        mState.useProgram(mProgram);
+        mLogo.model = glm::mat4(1.0f);
+        mLogo.renderFrom(mState, mFeedback.buffer(), static_cast<GLsizei>(mFeedback.size()));
+        mFrameStats.drawCalls++;
+        mFrameStats.instances += mFeedback.size();
+    }
+    else if (instanced) {
+        mInstanceRenderer.draw(mState, mFrameStats);
+        mFrameStats.submitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - submitStart).count();
+    }
+    else {
+        mState.useProgram(mProgram);
+        for (std::size_t i = 0; i < mLogos.size(); i++) {
+            mLogo.setPosition({mLogos.x[i], mLogos.y[i], 0.0f});
+            mLogo.updateTransform();
+            mLogo.render(mState);
+            mFrameStats.drawCalls++;
+            mFrameStats.instances++;
+        }
+    }
+
+    mPassTimer.endFrame(mFrameStats);
+
+    if (partial)
+        mState.disable(GL_SCISSOR_TEST);
+
+    // Grab the frame before presenting; the back buffer is undefined after.
+    if (!mOptions.screenshot.empty() && mFrame + 1 == mOptions.frames)
+        savePpm(mOptions.screenshot, readFramebuffer(kWindowWidth, kWindowHeight));
+    mFrame++;
+
+    if (!mOptions.headless)
+        mPresenter.swap(mWindow, mSwapRects);
+    if (trackDamage)
+        mDamage.endFrame();
+
+    mState.collect(mFrameStats);
+    if (mOptions.stats)
+        mStatsReporter.endFrame(mFrameStats);
+    mFrameStats.reset();
 }
 
 void App::run()
 {
-    while (!mShouldClose) {
-        events();
-        update();
+    // Low-power mode shows a frame once the logos have moved about a pixel
+    // and simulates the ticks in between without drawing them.
+    int ticksPerFrame = 1;
+    if (mOptions.lowPower && mOptions.speed < 1.0f)
+        ticksPerFrame = std::min(static_cast<int>(std::ceil(1.0f / mOptions.speed)), kMaxTicksPerFrame);
+    mFrameInterval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(static_cast<double>(ticksPerFrame) / kTickRate));
+    mNextFrame = std::chrono::steady_clock::now();
+
+    while (!mShouldClose && (mOptions.frames == 0 || mFrame < mOptions.frames)) {
+        // Without a window there are no events to wait for.
+        if (!mOptions.headless) {
+            if (mOptions.lowPower)
+                waitForFrame();
+            else
+                events();
+        }
+        if (mShouldClose)
+            break;
+
+        steer();
+        for (int tick = 0; tick < ticksPerFrame; tick++)
+            update();
         render();
+
+        if (mOptions.stats)
+            mCpuReporter.poll();
     }
 }
 
-int main()
+int main(int argc, char **argv)
 {
-    srand(static_cast<unsigned int>(time(nullptr)));
-
     try {
-        App app("DVD", kWindowWidth, kWindowHeight);
+        Options options = parseOptions(argc, argv);
+        srand(options.seed != 0 ? static_cast<unsigned int>(options.seed) : static_cast<unsigned int>(time(nullptr)));
+        App app("DVD", kWindowWidth, kWindowHeight, options);
     } catch (const std::runtime_error &e) {
         std::cerr << e.what() << std::endl;
         return 1;
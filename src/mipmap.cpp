@@ -0,0 +1,198 @@
+#include "mipmap.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+static constexpr char kCacheMagic[8] {'D', 'V', 'D', 'M', 'I', 'P', '1', '\0'};
+
+void premultiplyAlpha(Image &image)
+{
+    for (std::size_t i = 0; i < image.pixels.size(); i += 4) {
+        const unsigned alpha = image.pixels[i + 3];
+        for (std::size_t c = 0; c < 3; c++)
+            image.pixels[i + c] = static_cast<unsigned char>((image.pixels[i + c] * alpha + 127) / 255);
+    }
+}
+
+int mipLevels(int width, int height)
+{
+    int levels = 1;
+    while ((std::max(width, height) >> levels) > 0)
+        levels++;
+    return levels;
+}
+
+static void averageQuad(const unsigned char *a, const unsigned char *b, const unsigned char *c, const unsigned char *d, unsigned char *out)
+{
+    for (int i = 0; i < 4; i++)
+        out[i] = static_cast<unsigned char>((a[i] + b[i] + c[i] + d[i] + 2) / 4);
+}
+
+Image downsample(const Image &src)
+{
+    Image dst;
+    dst.width = std::max(1, src.width / 2);
+    dst.height = std::max(1, src.height / 2);
+    dst.pixels.resize(static_cast<std::size_t>(dst.width) * dst.height * 4);
+
+    const std::size_t srcStride = static_cast<std::size_t>(src.width) * 4;
+#ifdef __SSE2__
+    // Output columns whose 2x2 source block lies fully inside the row.
+    const int pairedColumns = src.width / 2;
+#endif
+
+    for (int y = 0; y < dst.height; y++) {
+        const unsigned char *row0 = src.pixels.data() + std::min(y * 2, src.height - 1) * srcStride;
+        const unsigned char *row1 = src.pixels.data() + std::min(y * 2 + 1, src.height - 1) * srcStride;
+        unsigned char *out = dst.pixels.data() + static_cast<std::size_t>(y) * dst.width * 4;
+
+        // Average the two rows, then even and odd pixels. Two rounding
+        // averages bias up by at most one step, which is invisible and keeps
+        // everything in 8-bit lanes.
+        int x = 0;
+#ifdef __SSE2__
+        for (; x + 4 <= pairedColumns; x += 4) {
+            const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + x * 8));
+            const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + x * 8 + 16));
+            const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + x * 8));
+            const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + x * 8 + 16));
+            const __m128 v0 = _mm_castsi128_ps(_mm_avg_epu8(a0, b0));
+            const __m128 v1 = _mm_castsi128_ps(_mm_avg_epu8(a1, b1));
+            const __m128i even = _mm_castps_si128(_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(2, 0, 2, 0)));
+            const __m128i odd = _mm_castps_si128(_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(3, 1, 3, 1)));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x * 4), _mm_avg_epu8(even, odd));
+        }
+#endif
+        for (; x < dst.width; x++) {
+            const int x0 = std::min(x * 2, src.width - 1);
+            const int x1 = std::min(x * 2 + 1, src.width - 1);
+            averageQuad(row0 + x0 * 4, row0 + x1 * 4, row1 + x0 * 4, row1 + x1 * 4, out + x * 4);
+        }
+    }
+
+    return dst;
+}
+
+/* Levels in the chain of base, with maxLevels 0 meaning all of them. */
+static int chainLevels(const Image &base, int maxLevels)
+{
+    const int levels = mipLevels(base.width, base.height);
+    return maxLevels > 0 ? std::min(levels, maxLevels) : levels;
+}
+
+std::vector<Image> buildMipChain(const Image &base, int maxLevels)
+{
+    const int levels = chainLevels(base, maxLevels);
+    std::vector<Image> chain;
+    chain.reserve(static_cast<std::size_t>(levels));
+    chain.push_back(base);
+    while (static_cast<int>(chain.size()) < levels)
+        chain.push_back(downsample(chain.back()));
+    return chain;
+}
+
+static std::uint64_t hashImage(const Image &image)
+{
+    // FNV-1a style over 64-bit words in four independent lanes, so the
+    // multiplies overlap instead of forming one long dependency chain. Only
+    // has to tell logos apart, not resist tampering.
+    constexpr std::uint64_t kPrime {0x100000001b3ull};
+    std::uint64_t lanes[4] {0xcbf29ce484222325ull, 0x84222325cbf29ce4ull, 0x9e3779b97f4a7c15ull, 0xbf58476d1ce4e5b9ull};
+
+    const std::size_t size = image.pixels.size();
+    std::size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        std::uint64_t words[4];
+        std::memcpy(words, image.pixels.data() + i, sizeof(words));
+        for (int lane = 0; lane < 4; lane++)
+            lanes[lane] = (lanes[lane] ^ words[lane]) * kPrime;
+    }
+    for (; i < size; i++)
+        lanes[0] = (lanes[0] ^ image.pixels[i]) * kPrime;
+
+    std::uint64_t hash = static_cast<std::uint64_t>(image.width) << 32 | static_cast<std::uint32_t>(image.height);
+    for (std::uint64_t lane : lanes)
+        hash = (hash ^ lane) * kPrime;
+    return hash;
+}
+
+static bool readCache(const std::string &path, const Image &base, int levels, std::vector<Image> &chain)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    char magic[sizeof(kCacheMagic)];
+    std::int32_t header[3];
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char *>(header), sizeof(header));
+    if (!file || std::memcmp(magic, kCacheMagic, sizeof(magic)) != 0 || header[0] != base.width || header[1] != base.height || header[2] != levels)
+        return false;
+
+    // Level 0 is the image we hashed, so only the smaller levels are stored.
+    chain.assign(1, base);
+    while (static_cast<int>(chain.size()) < levels) {
+        Image level;
+        level.width = std::max(1, chain.back().width / 2);
+        level.height = std::max(1, chain.back().height / 2);
+        level.pixels.resize(static_cast<std::size_t>(level.width) * level.height * 4);
+        file.read(reinterpret_cast<char *>(level.pixels.data()), static_cast<std::streamsize>(level.pixels.size()));
+        if (!file)
+            return false;
+        chain.push_back(std::move(level));
+    }
+    return true;
+}
+
+static void writeCache(const std::string &path, const std::vector<Image> &chain)
+{
+    // Write then rename, so a crash or a second instance never leaves a
+    // truncated file behind under the real name.
+    const std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        const std::int32_t header[3] {chain.front().width, chain.front().height, static_cast<std::int32_t>(chain.size())};
+        file.write(kCacheMagic, sizeof(kCacheMagic));
+        file.write(reinterpret_cast<const char *>(header), sizeof(header));
+        for (std::size_t level = 1; level < chain.size(); level++)
+            file.write(reinterpret_cast<const char *>(chain[level].pixels.data()), static_cast<std::streamsize>(chain[level].pixels.size()));
+        if (!file)
+            return;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+}
+
+std::vector<Image> loadMipChain(const Image &base, const std::string &cacheDir, int maxLevels)
+{
+    if (cacheDir.empty())
+        return buildMipChain(base, maxLevels);
+
+    // The level count is part of the name, so a truncated chain never
+    // evicts the full one of the same image.
+    const int levels = chainLevels(base, maxLevels);
+    std::stringstream name;
+    name << std::hex << hashImage(base) << std::dec << "-" << levels << ".mip";
+    const std::string path = (std::filesystem::path(cacheDir) / name.str()).string();
+
+    std::vector<Image> chain;
+    if (readCache(path, base, levels, chain))
+        return chain;
+
+    chain = buildMipChain(base, levels);
+    std::error_code error;
+    std::filesystem::create_directories(cacheDir, error);
+    // The cache is only an optimisation; failing to write it is not an error.
+    if (!error)
+        writeCache(path, chain);
+    return chain;
+}
@@ -0,0 +1,35 @@
+#ifndef MIPMAP_H
+#define MIPMAP_H
+
+#include "util.h"
+
+#include <string>
+#include <vector>
+
+/* Scales colour by alpha in place, for GL_ONE, GL_ONE_MINUS_SRC_ALPHA blending. */
+void premultiplyAlpha(Image &image);
+
+/* Number of levels in a full mip chain down to 1x1. */
+int mipLevels(int width, int height);
+
+/*
+ * Halves src with a 2x2 box filter. Sizes round down as GL's own level sizes
+ * do, so an odd last row or column is dropped, and a side already 1 pixel
+ * wide is averaged with itself. SSE2 produces four output pixels at a time.
+ */
+Image downsample(const Image &src);
+
+/*
+ * base followed by every smaller level down to 1x1, or only the first
+ * maxLevels levels; levels past the limit are never computed.
+ */
+std::vector<Image> buildMipChain(const Image &base, int maxLevels = 0);
+
+/*
+ * buildMipChain() with an on-disk cache in cacheDir, keyed by a hash of the
+ * base level and the level count. An empty cacheDir always builds;
+ * unreadable or stale cache files are rebuilt and rewritten.
+ */
+std::vector<Image> loadMipChain(const Image &base, const std::string &cacheDir, int maxLevels = 0);
+
+#endif    // MIPMAP_H
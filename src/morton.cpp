@@ -0,0 +1,200 @@
+#include "morton.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// Below this many logos the threads cost more than they save.
+static constexpr std::size_t kParallelThreshold {1 << 16};
+static constexpr int kRadixBits {8};
+static constexpr std::size_t kBuckets {1 << kRadixBits};
+
+static std::uint32_t spreadBits(std::uint32_t v)
+{
+    v &= 0x0000ffff;
+    v = (v | (v << 8)) & 0x00ff00ff;
+    v = (v | (v << 4)) & 0x0f0f0f0f;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+static std::uint32_t quantize(float value, float min, float max)
+{
+    float t = (value - min) / std::max(max - min, 1.0f);
+    t = std::max(0.0f, std::min(t, 1.0f));
+    return static_cast<std::uint32_t>(t * 65535.0f);
+}
+
+std::uint32_t mortonCode(float x, float y, const Bounds &bounds)
+{
+    return spreadBits(quantize(x, bounds.minX, bounds.maxX)) | (spreadBits(quantize(y, bounds.minY, bounds.maxY)) << 1);
+}
+
+template <typename Fn>
+static void parallelFor(WorkerPool &pool, unsigned threads, std::size_t count, Fn fn)
+{
+    pool.run(threads, [&](unsigned t) {
+        fn(t, count * t / threads, count * (t + 1) / threads);
+    });
+}
+
+static double neighbourSpread(const Logos &logos)
+{
+    if (logos.size() < 2)
+        return 0.0;
+
+    double total = 0.0;
+    for (std::size_t i = 1; i < logos.size(); i++)
+        total += std::hypot(logos.x[i] - logos.x[i - 1], logos.y[i] - logos.y[i - 1]);
+    return total / static_cast<double>(logos.size() - 1);
+}
+
+void MortonSorter::init(std::size_t count, unsigned threads, bool measureSpread)
+{
+    mPool.init(threads);
+    mThreads = mPool.threads();
+    mMeasureSpread = measureSpread;
+
+    mKeys.resize(count);
+    mKeysScratch.resize(count);
+    mOrder.resize(count);
+    mOrderScratch.resize(count);
+    mHistograms.resize(kBuckets * mThreads);
+    mFloatScratch.resize(count);
+    mTrailScratch.resize(count * 2);
+
+    mHandleAt.resize(count);
+    mIndexOf.resize(count);
+    for (std::size_t i = 0; i < count; i++) {
+        mHandleAt[i] = static_cast<std::uint32_t>(i);
+        mIndexOf[i] = static_cast<std::uint32_t>(i);
+    }
+
+    mStats = MortonStats {};
+}
+
+void MortonSorter::radixSort()
+{
+    const std::size_t count = mKeys.size();
+    const unsigned threads = count >= kParallelThreshold ? mThreads : 1;
+
+    for (int shift = 0; shift < 32; shift += kRadixBits) {
+        std::fill(mHistograms.begin(), mHistograms.end(), 0);
+
+        parallelFor(mPool, threads, count, [&](unsigned t, std::size_t begin, std::size_t end) {
+            std::size_t *histogram = &mHistograms[t * kBuckets];
+            for (std::size_t i = begin; i < end; i++)
+                histogram[(mKeys[i] >> shift) & (kBuckets - 1)]++;
+        });
+
+        // Exclusive prefix sum over (bucket, thread) keeps the sort stable.
+        std::size_t offset = 0;
+        for (std::size_t bucket = 0; bucket < kBuckets; bucket++) {
+            for (unsigned t = 0; t < threads; t++) {
+                std::size_t n = mHistograms[t * kBuckets + bucket];
+                mHistograms[t * kBuckets + bucket] = offset;
+                offset += n;
+            }
+        }
+
+        parallelFor(mPool, threads, count, [&](unsigned t, std::size_t begin, std::size_t end) {
+            std::size_t *offsets = &mHistograms[t * kBuckets];
+            for (std::size_t i = begin; i < end; i++) {
+                std::size_t dst = offsets[(mKeys[i] >> shift) & (kBuckets - 1)]++;
+                mKeysScratch[dst] = mKeys[i];
+                mOrderScratch[dst] = mOrder[i];
+            }
+        });
+
+        mKeys.swap(mKeysScratch);
+        mOrder.swap(mOrderScratch);
+    }
+}
+
+void MortonSorter::permute(std::vector<float> &values, unsigned threads)
+{
+    parallelFor(mPool, threads, mOrder.size(), [&](unsigned, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++)
+            mFloatScratch[i] = values[mOrder[i]];
+    });
+    values.swap(mFloatScratch);
+}
+
+/* Trail slots live inside one buffer, so they are copied back rather than swapped. */
+void MortonSorter::permuteTrailSlot(float *positions, unsigned threads)
+{
+    parallelFor(mPool, threads, mOrder.size(), [&](unsigned, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            mTrailScratch[i * 2 + 0] = positions[mOrder[i] * 2 + 0];
+            mTrailScratch[i * 2 + 1] = positions[mOrder[i] * 2 + 1];
+        }
+    });
+    parallelFor(mPool, threads, mOrder.size(), [&](unsigned, std::size_t begin, std::size_t end) {
+        std::copy(mTrailScratch.begin() + begin * 2, mTrailScratch.begin() + end * 2, positions + begin * 2);
+    });
+}
+
+void MortonSorter::sort(Logos &logos, const Bounds &bounds, TrailBuffer *trails)
+{
+    const std::size_t count = logos.size();
+    if (count != mKeys.size())
+        init(count, mThreads, mMeasureSpread);
+
+    // Walks every logo, so only when asked for and outside the timing.
+    if (mMeasureSpread)
+        mStats.spreadBefore = neighbourSpread(logos);
+    auto start = std::chrono::steady_clock::now();
+
+    const unsigned threads = count >= kParallelThreshold ? mThreads : 1;
+    parallelFor(mPool, threads, count, [&](unsigned, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            mKeys[i] = mortonCode(logos.x[i], logos.y[i], bounds);
+            mOrder[i] = static_cast<std::uint32_t>(i);
+        }
+    });
+
+    radixSort();
+
+    permute(logos.x, threads);
+    permute(logos.y, threads);
+    permute(logos.vx, threads);
+    permute(logos.vy, threads);
+
+    if (trails && trails->logoCount() == count) {
+        for (std::size_t slot = 0; slot < trails->length(); slot++)
+            permuteTrailSlot(trails->mutableData() + slot * count * 2, threads);
+    }
+
+    // The key and order scratch are free again once the radix sort is done.
+    // mOrder is a permutation, so the mIndexOf scatter never collides.
+    parallelFor(mPool, threads, count, [&](unsigned, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            mKeysScratch[i] = logos.id[mOrder[i]];
+            mOrderScratch[i] = mHandleAt[mOrder[i]];
+            mIndexOf[mOrderScratch[i]] = static_cast<std::uint32_t>(i);
+        }
+    });
+    logos.id.swap(mKeysScratch);
+    mHandleAt.swap(mOrderScratch);
+
+    mStats.lastSortMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    mStats.sorts++;
+    if (mMeasureSpread)
+        mStats.spreadAfter = neighbourSpread(logos);
+}
+
+std::uint32_t MortonSorter::indexOf(std::uint32_t handle) const
+{
+    return mIndexOf[handle];
+}
+
+std::uint32_t MortonSorter::handleAt(std::uint32_t index) const
+{
+    return mHandleAt[index];
+}
+
+const MortonStats &MortonSorter::stats() const
+{
+    return mStats;
+}
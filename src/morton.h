@@ -0,0 +1,63 @@
+#ifndef MORTON_H
+#define MORTON_H
+
+#include "logos.h"
+#include "trails.h"
+#include "worker_pool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+std::uint32_t mortonCode(float x, float y, const Bounds &bounds);
+
+struct MortonStats {
+    std::size_t sorts {0};
+    double lastSortMs {0.0};
+    /* Mean distance in pixels between logos adjacent in memory, before and
+     * after the last sort. Neighbour queries get cheaper as this shrinks.
+     * Only measured when the sorter was initialised to. */
+    double spreadBefore {0.0};
+    double spreadAfter {0.0};
+};
+
+/*
+ * Reorders the logo arrays along a Z-order curve so that logos close on
+ * screen are close in memory. Uses a parallel LSD radix sort over
+ * preallocated scratch arrays, then gathers the arrays into the new order on
+ * the same threads, and keeps stable handles for callers that need to
+ * follow a particular logo across sorts.
+ */
+class MortonSorter {
+public:
+    /* measureSpread fills in MortonStats' spreads, at two extra passes per sort. */
+    void init(std::size_t count, unsigned threads = 0, bool measureSpread = false);
+
+    void sort(Logos &logos, const Bounds &bounds, TrailBuffer *trails = nullptr);
+
+    std::uint32_t indexOf(std::uint32_t handle) const;
+    std::uint32_t handleAt(std::uint32_t index) const;
+
+    const MortonStats &stats() const;
+
+private:
+    void radixSort();
+    void permute(std::vector<float> &values, unsigned threads);
+    void permuteTrailSlot(float *positions, unsigned threads);
+
+    WorkerPool mPool;
+    unsigned mThreads {1};
+    bool mMeasureSpread {false};
+    std::vector<std::uint32_t> mKeys;
+    std::vector<std::uint32_t> mKeysScratch;
+    std::vector<std::uint32_t> mOrder;
+    std::vector<std::uint32_t> mOrderScratch;
+    std::vector<std::size_t> mHistograms;
+    std::vector<float> mFloatScratch;
+    std::vector<float> mTrailScratch;
+    std::vector<std::uint32_t> mHandleAt;
+    std::vector<std::uint32_t> mIndexOf;
+    MortonStats mStats;
+};
+
+#endif    // MORTON_H
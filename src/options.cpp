@@ -0,0 +1,192 @@
+#include "options.h"
+
+#include <stdexcept>
+#include <string>
+
+static const char *kUsage =
+    "Usage: dvd [options]\n"
+    "  --logos=N              number of bouncing logos (default 1)\n"
+    "  --sim=cpu|feedback|packed|blocks\n"
+    "                         simulation backend (default cpu); packed keeps\n"
+    "                         8 bytes of state per logo, blocks steps logos in\n"
+    "                         16-wide AoSoA blocks\n"
+    "  --render=objects|instanced|software|vulkan\n"
+    "                         one draw per logo, one draw for all logos, the\n"
+    "                         multithreaded CPU rasterizer with no GL, or\n"
+    "                         instanced Vulkan when built with DVD_VULKAN\n"
+    "                         (default instanced)\n"
+    "  --logo-dir=DIR         draw the PNG logos in DIR, packed into atlases\n"
+    "                         (instanced path only)\n"
+    "  --textures=atlas|array|bindless\n"
+    "                         pack logos into atlases, use one texture array\n"
+    "                         layer per logo when they share a size, or one\n"
+    "                         bindless texture per logo when the driver has\n"
+    "                         GL_ARB_bindless_texture (default atlas)\n"
+    "  --mip-cache=DIR        keep built logo mip chains in DIR and reuse them\n"
+    "                         on later starts (default off)\n"
+    "  --program-cache=DIR    keep linked shader program binaries in DIR and\n"
+    "                         reuse them on later starts (default off)\n"
+    "  --logo-scale=F         draw logos at F times their image size\n"
+    "                         (instanced path only, default 1)\n"
+    "  --speed=F              logo speed in pixels per tick (default 4)\n"
+    "  --low-power            sleep between frames, drop the frame rate while\n"
+    "                         motion stays under a pixel a frame, and stop\n"
+    "                         rendering while the window is hidden\n"
+    "  --trail=K              keep K past positions per logo for motion trails,\n"
+    "                         using logos * K * 8 bytes (default 0, off)\n"
+    "  --resort=N             re-sort logos into Morton order every N ticks\n"
+    "                         (cpu backend only, default 0, off)\n"
+    "  --damage               only redraw and present the parts of the window\n"
+    "                         that changed; needs EGL with buffer age, so\n"
+    "                         forces EGL on X11 (not with --sim=feedback)\n"
+    "  --headless             render offscreen through EGL's surfaceless\n"
+    "                         platform, with no window or display server\n"
+    "  --gles                 use GLES 3.1 even where desktop GL 4.6 exists;\n"
+    "                         GLES is picked by itself when it is all there is\n"
+    "                         (instanced path only)\n"
+    "  --frames=N             exit after N frames (default 0, never)\n"
+    "  --screenshot=FILE      write the last frame to FILE as a PPM image\n"
+    "                         (needs --frames)\n"
+    "  --seed=N               seed logo placement, for reproducible frames\n"
+    "                         (default 0, seed from the clock)\n"
+    "  --stats                print performance counters\n"
+    "  --validate-gl-state    check the GL state cache against the driver\n";
+
+static float parsePositive(const std::string &name, const std::string &value)
+{
+    try {
+        std::size_t used = 0;
+        float scale = std::stof(value, &used);
+        if (used == value.size() && scale > 0.0f)
+            return scale;
+    } catch (const std::logic_error &) {
+    }
+    throw std::runtime_error("Invalid value for " + name + ": " + value + "\n" + kUsage);
+}
+
+static std::size_t parseCount(const std::string &name, const std::string &value)
+{
+    try {
+        std::size_t used = 0;
+        unsigned long long count = std::stoull(value, &used);
+        if (used == value.size())
+            return static_cast<std::size_t>(count);
+    } catch (const std::logic_error &) {
+    }
+    throw std::runtime_error("Invalid value for " + name + ": " + value + "\n" + kUsage);
+}
+
+Options parseOptions(int argc, char **argv)
+{
+    Options options;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+        std::string name = arg.substr(0, arg.find('='));
+        std::string value = arg.find('=') == std::string::npos ? "" : arg.substr(arg.find('=') + 1);
+
+        if (name == "--logos") {
+            options.logoCount = parseCount(name, value);
+            if (options.logoCount == 0)
+                throw std::runtime_error(std::string("--logos must be at least 1\n") + kUsage);
+        }
+        else if (name == "--sim") {
+            if (value == "cpu")
+                options.sim = SimBackend::Cpu;
+            else if (value == "feedback")
+                options.sim = SimBackend::Feedback;
+            else if (value == "packed")
+                options.sim = SimBackend::Packed;
+            else if (value == "blocks")
+                options.sim = SimBackend::Blocks;
+            else
+                throw std::runtime_error("Unknown simulation backend: " + value + "\n" + kUsage);
+        }
+        else if (name == "--render") {
+            if (value == "objects")
+                options.render = RenderPath::Objects;
+            else if (value == "instanced")
+                options.render = RenderPath::Instanced;
+            else if (value == "software")
+                options.render = RenderPath::Software;
+            else if (value == "vulkan")
+                options.render = RenderPath::Vulkan;
+            else
+                throw std::runtime_error("Unknown render path: " + value + "\n" + kUsage);
+        }
+        else if (name == "--logo-dir") {
+            options.logoDir = value;
+        }
+        else if (name == "--textures") {
+            if (value == "atlas")
+                options.textures = TextureMode::Atlas;
+            else if (value == "array")
+                options.textures = TextureMode::Array;
+            else if (value == "bindless")
+                options.textures = TextureMode::Bindless;
+            else
+                throw std::runtime_error("Unknown texture mode: " + value + "\n" + kUsage);
+        }
+        else if (name == "--mip-cache") {
+            options.mipCacheDir = value;
+        }
+        else if (name == "--program-cache") {
+            options.programCacheDir = value;
+        }
+        else if (name == "--logo-scale") {
+            options.logoScale = parsePositive(name, value);
+        }
+        else if (name == "--speed") {
+            options.speed = parsePositive(name, value);
+        }
+        else if (name == "--low-power") {
+            options.lowPower = true;
+        }
+        else if (name == "--trail") {
+            options.trailLength = parseCount(name, value);
+        }
+        else if (name == "--resort") {
+            options.resortInterval = parseCount(name, value);
+        }
+        else if (name == "--damage") {
+            options.damage = true;
+        }
+        else if (name == "--headless") {
+            options.headless = true;
+        }
+        else if (name == "--gles") {
+            options.gles = true;
+        }
+        else if (name == "--frames") {
+            options.frames = parseCount(name, value);
+        }
+        else if (name == "--screenshot") {
+            options.screenshot = value;
+        }
+        else if (name == "--seed") {
+            options.seed = parseCount(name, value);
+        }
+        else if (name == "--stats") {
+            options.stats = true;
+        }
+        else if (name == "--validate-gl-state") {
+            options.validateGlState = true;
+        }
+        else {
+            throw std::runtime_error("Unknown option: " + arg + "\n" + kUsage);
+        }
+    }
+
+    if (options.render == RenderPath::Software && (options.sim == SimBackend::Feedback || options.trailLength > 0))
+        throw std::runtime_error(std::string("--render=software needs a CPU simulation backend and no trails\n") + kUsage);
+    if (options.render == RenderPath::Vulkan && (options.sim == SimBackend::Feedback || options.trailLength > 0 || options.damage))
+        throw std::runtime_error(std::string("--render=vulkan needs a CPU simulation backend, no trails and no --damage\n") + kUsage);
+    if (options.render == RenderPath::Vulkan && !options.screenshot.empty() && !options.headless)
+        throw std::runtime_error(std::string("--render=vulkan takes screenshots only with --headless\n") + kUsage);
+    if (options.gles && (options.render != RenderPath::Instanced || options.sim == SimBackend::Feedback || options.trailLength > 0))
+        throw std::runtime_error(std::string("--gles needs --render=instanced, a CPU simulation backend and no trails\n") + kUsage);
+    if (!options.screenshot.empty() && options.frames == 0)
+        throw std::runtime_error(std::string("--screenshot needs --frames\n") + kUsage);
+
+    return options;
+}
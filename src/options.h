@@ -0,0 +1,66 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <cstddef>
+#include <string>
+
+enum class SimBackend {
+    Cpu,
+    Feedback,
+    Packed,
+    Blocks,
+};
+
+enum class RenderPath {
+    Objects,
+    Instanced,
+    Software,
+    Vulkan,
+};
+
+enum class TextureMode {
+    Atlas,
+    Array,
+    Bindless,
+};
+
+struct Options {
+    std::size_t logoCount {1};
+    SimBackend sim {SimBackend::Cpu};
+    RenderPath render {RenderPath::Instanced};
+    /* Directory of PNG logos packed into an atlas; empty for logo.png only. */
+    std::string logoDir;
+    TextureMode textures {TextureMode::Atlas};
+    /* Directory for prebuilt mip chains; empty to build them on every start. */
+    std::string mipCacheDir;
+    /* Directory for linked program binaries; empty to compile on every start. */
+    std::string programCacheDir;
+    /* Drawn size of the logos relative to their images. */
+    float logoScale {1.0f};
+    /* Pixels each logo moves per simulation tick. */
+    float speed {4.0f};
+    bool lowPower {false};
+    /* Positions remembered per logo for trails; costs logos * trail * 8 bytes. */
+    std::size_t trailLength {0};
+    /* Ticks between Morton-order re-sorts of the logo arrays, 0 to never sort. */
+    std::size_t resortInterval {0};
+    /* Redraw and present only what moved, where EGL buffer age allows. */
+    bool damage {false};
+    /* Render into an offscreen framebuffer with no window (EGL surfaceless). */
+    bool headless {false};
+    /* Use the GLES 3.1 path even where desktop GL 4.6 is available. */
+    bool gles {false};
+    /* Frames to render before exiting, 0 to run until closed. */
+    std::size_t frames {0};
+    /* PPM file to write the last frame to; needs frames. */
+    std::string screenshot;
+    /* Seed for spawning logos, 0 to seed from the clock. */
+    std::size_t seed {0};
+    bool stats {false};
+    /* Check the GL state tracker against glGet* on every call. */
+    bool validateGlState {false};
+};
+
+Options parseOptions(int argc, char **argv);
+
+#endif    // OPTIONS_H
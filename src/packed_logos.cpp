@@ -0,0 +1,161 @@
+#include "packed_logos.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+static constexpr float kFixedMax {65535.0f};
+static constexpr float kTwoPi {6.28318530718f};
+
+static std::uint8_t packDirection(float vx, float vy)
+{
+    float angle = std::atan2(vy, vx) / kTwoPi * 256.0f;
+    return static_cast<std::uint8_t>(static_cast<int>(std::lround(angle)) & 0xff);
+}
+
+static std::uint16_t packCoordinate(float value, float scale)
+{
+    return static_cast<std::uint16_t>(std::max(0.0f, std::min(value * scale + 0.5f, kFixedMax)));
+}
+
+void PackedLogos::init(int arenaWidth, int arenaHeight, float speed)
+{
+    mScaleX = kFixedMax / static_cast<float>(arenaWidth);
+    mScaleY = kFixedMax / static_cast<float>(arenaHeight);
+
+    for (int i = 0; i < 256; i++) {
+        float angle = static_cast<float>(i) / 256.0f * kTwoPi;
+        mDirX[i] = std::cos(angle);
+        mDirY[i] = std::sin(angle);
+        mStepX[i] = static_cast<std::int32_t>(std::lround(mDirX[i] * speed * mScaleX));
+        mStepY[i] = static_cast<std::int32_t>(std::lround(mDirY[i] * speed * mScaleY));
+    }
+}
+
+void PackedLogos::pack(const Logos &logos)
+{
+    const std::size_t count = logos.size();
+    mLogos.resize(count);
+
+    std::size_t i = 0;
+#ifdef __SSE2__
+    // Four logos per iteration: scale, round and saturate to u16 (via the
+    // signed pack with a 0x8000 bias), then interleave {x, y} with the
+    // direction word to form two 16-byte stores.
+    const __m128 scaleX = _mm_set1_ps(mScaleX);
+    const __m128 scaleY = _mm_set1_ps(mScaleY);
+    const __m128i bias = _mm_set1_epi32(0x8000);
+    const __m128i unbias = _mm_set1_epi16(static_cast<short>(0x8000));
+    for (; i + 4 <= count; i += 4) {
+        __m128i xs = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(&logos.x[i]), scaleX));
+        __m128i ys = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(&logos.y[i]), scaleY));
+        xs = _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(xs, bias), _mm_setzero_si128()), unbias);
+        ys = _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(ys, bias), _mm_setzero_si128()), unbias);
+        __m128i xy = _mm_unpacklo_epi16(xs, ys);
+
+        __m128i dirs = _mm_setr_epi32(packDirection(logos.vx[i + 0], logos.vy[i + 0]),
+                                      packDirection(logos.vx[i + 1], logos.vy[i + 1]),
+                                      packDirection(logos.vx[i + 2], logos.vy[i + 2]),
+                                      packDirection(logos.vx[i + 3], logos.vy[i + 3]));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&mLogos[i]), _mm_unpacklo_epi32(xy, dirs));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&mLogos[i + 2]), _mm_unpackhi_epi32(xy, dirs));
+    }
+#endif
+    for (; i < count; i++) {
+        PackedLogo &logo = mLogos[i];
+        logo.x = packCoordinate(logos.x[i], mScaleX);
+        logo.y = packCoordinate(logos.y[i], mScaleY);
+        logo.direction = packDirection(logos.vx[i], logos.vy[i]);
+        std::memset(logo.reserved, 0, sizeof(logo.reserved));
+    }
+}
+
+void PackedLogos::unpack(Logos &logos) const
+{
+    const std::size_t count = mLogos.size();
+    logos.resize(count);
+
+    const float invScaleX = 1.0f / mScaleX;
+    const float invScaleY = 1.0f / mScaleY;
+
+    std::size_t i = 0;
+#ifdef __SSE2__
+    const __m128 invX = _mm_set1_ps(invScaleX);
+    const __m128 invY = _mm_set1_ps(invScaleY);
+    const __m128i lowHalf = _mm_set1_epi32(0xffff);
+    for (; i + 4 <= count; i += 4) {
+        __m128 a = _mm_loadu_ps(reinterpret_cast<const float *>(&mLogos[i]));
+        __m128 b = _mm_loadu_ps(reinterpret_cast<const float *>(&mLogos[i + 2]));
+        __m128i xy = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+
+        __m128 xs = _mm_cvtepi32_ps(_mm_and_si128(xy, lowHalf));
+        __m128 ys = _mm_cvtepi32_ps(_mm_srli_epi32(xy, 16));
+        _mm_storeu_ps(&logos.x[i], _mm_mul_ps(xs, invX));
+        _mm_storeu_ps(&logos.y[i], _mm_mul_ps(ys, invY));
+
+        for (std::size_t j = i; j < i + 4; j++) {
+            logos.vx[j] = mDirX[mLogos[j].direction];
+            logos.vy[j] = mDirY[mLogos[j].direction];
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        const PackedLogo &logo = mLogos[i];
+        logos.x[i] = static_cast<float>(logo.x) * invScaleX;
+        logos.y[i] = static_cast<float>(logo.y) * invScaleY;
+        logos.vx[i] = mDirX[logo.direction];
+        logos.vy[i] = mDirY[logo.direction];
+    }
+}
+
+void PackedLogos::step(const Bounds &bounds)
+{
+    const std::int32_t minX = packCoordinate(bounds.minX, mScaleX);
+    const std::int32_t maxX = packCoordinate(bounds.maxX, mScaleX);
+    const std::int32_t minY = packCoordinate(bounds.minY, mScaleY);
+    const std::int32_t maxY = packCoordinate(bounds.maxY, mScaleY);
+
+    // Local copies of the step tables: the u8 stores below may alias any
+    // member, which would otherwise force a reload every iteration.
+    std::int32_t stepX[256];
+    std::int32_t stepY[256];
+    std::memcpy(stepX, mStepX, sizeof(stepX));
+    std::memcpy(stepY, mStepY, sizeof(stepY));
+
+    // Each logo is handled as one little-endian 64-bit word (x in bits 0-15,
+    // y in 16-31, direction in 32-39) so it is loaded and stored whole; going
+    // through the struct fields costs a store-forwarding stall per logo.
+    //
+    // Reflections act on the angle: mirroring across the y axis maps a to
+    // 128 - a, across the x axis maps a to -a (both mod 256).
+    PackedLogo *logos = mLogos.data();
+    const std::size_t count = mLogos.size();
+    for (std::size_t i = 0; i < count; i++) {
+        std::uint64_t word;
+        std::memcpy(&word, &logos[i], sizeof(word));
+
+        std::uint32_t dir = static_cast<std::uint32_t>(word >> 32) & 0xff;
+        std::int32_t dx = stepX[dir];
+        std::int32_t dy = stepY[dir];
+        std::int32_t x = std::max(0, std::min(static_cast<std::int32_t>(word & 0xffff) + dx, 0xffff));
+        std::int32_t y = std::max(0, std::min(static_cast<std::int32_t>((word >> 16) & 0xffff) + dy, 0xffff));
+
+        int flipX = ((x >= maxX) & (dx > 0)) | ((x <= minX) & (dx < 0));
+        int flipY = ((y >= maxY) & (dy > 0)) | ((y <= minY) & (dy < 0));
+        dir = flipX ? (128 - dir) & 0xff : dir;
+        dir = flipY ? (0u - dir) & 0xff : dir;
+
+        word = (word & 0xffffff0000000000ull) | (static_cast<std::uint64_t>(dir) << 32) | (static_cast<std::uint64_t>(y) << 16) | static_cast<std::uint64_t>(x);
+        std::memcpy(&logos[i], &word, sizeof(word));
+    }
+}
+
+std::size_t PackedLogos::size() const
+{
+    return mLogos.size();
+}
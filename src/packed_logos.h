@@ -0,0 +1,46 @@
+#ifndef PACKED_LOGOS_H
+#define PACKED_LOGOS_H
+
+#include "logos.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * 8-byte logo state for counts where the update is bandwidth bound.
+ * Positions are 16-bit fixed point across the arena (about 0.012 px per step
+ * on an 800 px arena) and the velocity is one of 256 directions; its
+ * magnitude is the speed the state was created with.
+ */
+struct PackedLogo {
+    std::uint16_t x;
+    std::uint16_t y;
+    std::uint8_t direction;
+    std::uint8_t reserved[3];
+};
+
+static_assert(sizeof(PackedLogo) == 8, "PackedLogo must stay 8 bytes");
+
+class PackedLogos {
+public:
+    void init(int arenaWidth, int arenaHeight, float speed);
+
+    void pack(const Logos &logos);
+    void unpack(Logos &logos) const;
+
+    void step(const Bounds &bounds);
+
+    std::size_t size() const;
+
+private:
+    std::vector<PackedLogo> mLogos;
+    float mScaleX {1.0f};
+    float mScaleY {1.0f};
+    float mDirX[256];
+    float mDirY[256];
+    std::int32_t mStepX[256];
+    std::int32_t mStepY[256];
+};
+
+#endif    // PACKED_LOGOS_H
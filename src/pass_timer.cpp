@@ -0,0 +1,170 @@
+#include "pass_timer.h"
+
+#include "util.h"
+
+// From GL_EXT_disjoint_timer_query, which GLEW does not know about.
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
+PassTimer::~PassTimer()
+{
+    destroy();
+}
+
+void PassTimer::init()
+{
+    destroy();
+
+    // The extension's 64-bit result getter shares its name with
+    // GL_EXT_timer_query's, which GLEW does load.
+    mEs = glIsEs();
+    if (mEs)
+        mGpuSupported = glHasExtension("GL_EXT_disjoint_timer_query") && glGetQueryObjectui64vEXT;
+    else
+        mGpuSupported = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+    if (!mGpuSupported)
+        return;
+
+    for (Slot &slot : mSlots)
+        glGenQueries(static_cast<GLsizei>(kRenderPassCount), slot.queries.data());
+}
+
+void PassTimer::destroy()
+{
+    if (mGpuSupported) {
+        for (Slot &slot : mSlots)
+            glDeleteQueries(static_cast<GLsizei>(kRenderPassCount), slot.queries.data());
+    }
+    mGpuSupported = false;
+    mSlots = {};
+    mSlot = 0;
+    mOldest = 0;
+    mRecording = false;
+    mWarm = false;
+    mInPass = false;
+}
+
+bool PassTimer::gpuSupported() const
+{
+    return mGpuSupported;
+}
+
+void PassTimer::beginFrame(FrameStats &stats)
+{
+    mInPass = false;
+    mRecording = false;
+    if (!mGpuSupported)
+        return;
+
+    // Slots fill in ring order, so the landed ones are a run from the oldest.
+    std::size_t landed = 0;
+    while (landed < kSlots) {
+        const Slot &slot = mSlots[(mOldest + landed) % kSlots];
+        if (!slot.pending || !available(slot))
+            break;
+        landed++;
+    }
+
+    // Reading the flag clears it; whatever was in flight when it was set
+    // may be garbage, so drop the lot.
+    GLint disjoint = 0;
+    if (mEs)
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    if (disjoint) {
+        for (Slot &slot : mSlots)
+            slot.pending = false;
+        mOldest = mSlot;
+    }
+    else {
+        for (; landed > 0; landed--) {
+            collect(mSlots[mOldest], stats);
+            mOldest = (mOldest + 1) % kSlots;
+        }
+    }
+
+    // Still waiting on a full ring: skip this frame rather than reuse queries in flight.
+    Slot &slot = mSlots[mSlot];
+    mRecording = !slot.pending;
+    if (mRecording)
+        slot.issued = {};
+}
+
+void PassTimer::beginPass(RenderPass pass, FrameStats &stats)
+{
+    endPass(stats);
+
+    mPass = pass;
+    mInPass = true;
+    mPassStart = Clock::now();
+
+    if (mRecording) {
+        Slot &slot = mSlots[mSlot];
+        const auto index = static_cast<std::size_t>(pass);
+        glBeginQuery(GL_TIME_ELAPSED, slot.queries[index]);
+        slot.issued[index] = true;
+    }
+}
+
+void PassTimer::endFrame(FrameStats &stats)
+{
+    endPass(stats);
+
+    if (!mRecording)
+        return;
+    mRecording = false;
+
+    Slot &slot = mSlots[mSlot];
+    for (bool issued : slot.issued)
+        slot.pending = slot.pending || issued;
+    if (slot.pending)
+        mSlot = (mSlot + 1) % kSlots;
+}
+
+void PassTimer::endPass(FrameStats &stats)
+{
+    if (!mInPass)
+        return;
+    mInPass = false;
+
+    const auto index = static_cast<std::size_t>(mPass);
+    stats.passCpuMs[index] += std::chrono::duration<double, std::milli>(Clock::now() - mPassStart).count();
+    if (mRecording)
+        glEndQuery(GL_TIME_ELAPSED);
+}
+
+bool PassTimer::available(const Slot &slot) const
+{
+    for (std::size_t i = 0; i < kRenderPassCount; i++) {
+        if (!slot.issued[i])
+            continue;
+        GLuint done = GL_FALSE;
+        glGetQueryObjectuiv(slot.queries[i], GL_QUERY_RESULT_AVAILABLE, &done);
+        if (!done)
+            return false;
+    }
+    return true;
+}
+
+void PassTimer::collect(Slot &slot, FrameStats &stats)
+{
+    // llvmpipe times a context's first queries from its clock's epoch
+    // when nothing was drawn before them.
+    slot.pending = false;
+    if (!mWarm) {
+        mWarm = true;
+        return;
+    }
+
+    for (std::size_t i = 0; i < kRenderPassCount; i++) {
+        if (!slot.issued[i])
+            continue;
+        GLuint64 nanoseconds = 0;
+        if (mEs)
+            glGetQueryObjectui64vEXT(slot.queries[i], GL_QUERY_RESULT, &nanoseconds);
+        else
+            glGetQueryObjectui64v(slot.queries[i], GL_QUERY_RESULT, &nanoseconds);
+        stats.passGpuMs[i] += static_cast<double>(nanoseconds) * 1e-6;
+    }
+    stats.gpuFrames++;
+}
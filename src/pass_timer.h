@@ -0,0 +1,74 @@
+#ifndef PASS_TIMER_H
+#define PASS_TIMER_H
+
+#include "app_gl.h"
+#include "stats.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+/*
+ * Times each RenderPass on the CPU and, where timer queries exist, on the
+ * GPU. Passes run back to back, so each one is a single GL_TIME_ELAPSED
+ * query ended by the next pass or by endFrame().
+ *
+ * The queries of a frame go into one slot of a ring kSlots deep. Results
+ * are only read once GL_QUERY_RESULT_AVAILABLE says so, usually a couple of
+ * frames later; a frame whose slot is still waiting is simply not timed on
+ * the GPU, so nothing ever stalls on the pipeline.
+ *
+ * Desktop GL has timer queries from 3.3; GLES needs
+ * GL_EXT_disjoint_timer_query, and frames that saw a disjoint operation
+ * (e.g. a clock change) are dropped. Without either only CPU times are
+ * reported.
+ */
+class PassTimer {
+public:
+    static constexpr std::size_t kSlots {4};
+
+    ~PassTimer();
+
+    /* Creates the queries if the context has timer queries; CPU timing needs no init(). */
+    void init();
+    void destroy();
+
+    bool gpuSupported() const;
+
+    /* Publishes into stats the GPU times of earlier frames that have landed. */
+    void beginFrame(FrameStats &stats);
+    /* Ends the pass in progress, if any, and starts this one; each pass at most once a frame. */
+    void beginPass(RenderPass pass, FrameStats &stats);
+    void endFrame(FrameStats &stats);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Slot {
+        std::array<GLuint, kRenderPassCount> queries {};
+        std::array<bool, kRenderPassCount> issued {};
+        bool pending {false};
+    };
+
+    void endPass(FrameStats &stats);
+    /* True once every query the slot issued has its result. */
+    bool available(const Slot &slot) const;
+    void collect(Slot &slot, FrameStats &stats);
+
+    bool mGpuSupported {false};
+    bool mEs {false};
+    std::array<Slot, kSlots> mSlots {};
+    std::size_t mSlot {0};
+    /* Oldest slot that may still be pending. */
+    std::size_t mOldest {0};
+    /* Whether this frame's slot was free, and so takes queries. */
+    bool mRecording {false};
+    /* Set once the first frame's results, which are not trusted, are dropped. */
+    bool mWarm {false};
+
+    bool mInPass {false};
+    RenderPass mPass {RenderPass::Clear};
+    Clock::time_point mPassStart;
+};
+
+#endif    // PASS_TIMER_H
@@ -0,0 +1,108 @@
+#include "present.h"
+
+#define SDL_MAIN_HANDLED
+#ifdef __linux__
+#include <SDL2/SDL.h>
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#else
+#include <SDL.h>
+#endif
+
+#include <cstring>
+
+#ifdef __linux__
+static bool hasExtension(const char *extensions, const char *name)
+{
+    const std::size_t length = std::strlen(name);
+    for (const char *found = std::strstr(extensions, name); found; found = std::strstr(found + length, name)) {
+        const bool startsWord = found == extensions || found[-1] == ' ';
+        const bool endsWord = found[length] == ' ' || found[length] == '\0';
+        if (startsWord && endsWord)
+            return true;
+    }
+    return false;
+}
+
+/* EGL wants {x, y, width, height} quadruples with a bottom-left origin, the same as DamageRect. */
+static std::vector<EGLint> eglRects(const std::vector<DamageRect> &rects)
+{
+    std::vector<EGLint> values;
+    values.reserve(rects.size() * 4);
+    for (const DamageRect &rect : rects)
+        values.insert(values.end(), {rect.x, rect.y, rect.width, rect.height});
+    return values;
+}
+#endif
+
+void DamagePresenter::init()
+{
+    *this = DamagePresenter {};
+
+#ifdef __linux__
+    // SDL only creates EGL contexts on Wayland, or on X11 when asked to with
+    // SDL_HINT_VIDEO_X11_FORCE_EGL; under GLX there is no current EGL display.
+    EGLDisplay display = eglGetCurrentDisplay();
+    EGLSurface surface = eglGetCurrentSurface(EGL_DRAW);
+    if (display == EGL_NO_DISPLAY || surface == EGL_NO_SURFACE)
+        return;
+
+    const char *extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (!extensions)
+        return;
+
+    mDisplay = display;
+    mSurface = surface;
+    mBufferAge = hasExtension(extensions, "EGL_EXT_buffer_age") || hasExtension(extensions, "EGL_KHR_partial_update");
+    if (hasExtension(extensions, "EGL_KHR_partial_update"))
+        mSetDamageRegion = reinterpret_cast<void *>(eglGetProcAddress("eglSetDamageRegionKHR"));
+    if (hasExtension(extensions, "EGL_KHR_swap_buffers_with_damage"))
+        mSwapWithDamage = reinterpret_cast<void *>(eglGetProcAddress("eglSwapBuffersWithDamageKHR"));
+    else if (hasExtension(extensions, "EGL_EXT_swap_buffers_with_damage"))
+        mSwapWithDamage = reinterpret_cast<void *>(eglGetProcAddress("eglSwapBuffersWithDamageEXT"));
+#endif
+}
+
+int DamagePresenter::bufferAge() const
+{
+#ifdef __linux__
+    if (!mBufferAge)
+        return 0;
+
+    // EGL_BUFFER_AGE_KHR shares its value with EGL_BUFFER_AGE_EXT.
+    EGLint age = 0;
+    if (!eglQuerySurface(mDisplay, mSurface, EGL_BUFFER_AGE_KHR, &age))
+        return 0;
+    return age;
+#else
+    return 0;
+#endif
+}
+
+void DamagePresenter::setDamageRegion(const std::vector<DamageRect> &rects) const
+{
+#ifdef __linux__
+    if (!mSetDamageRegion || rects.empty())
+        return;
+
+    std::vector<EGLint> values = eglRects(rects);
+    reinterpret_cast<PFNEGLSETDAMAGEREGIONKHRPROC>(mSetDamageRegion)(mDisplay, mSurface, values.data(), static_cast<EGLint>(rects.size()));
+#else
+    (void)rects;
+#endif
+}
+
+void DamagePresenter::swap(SDL_Window *window, const std::vector<DamageRect> &rects) const
+{
+#ifdef __linux__
+    if (mSwapWithDamage && !rects.empty()) {
+        std::vector<EGLint> values = eglRects(rects);
+        reinterpret_cast<PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC>(mSwapWithDamage)(mDisplay, mSurface, values.data(), static_cast<EGLint>(rects.size()));
+        return;
+    }
+#else
+    (void)rects;
+#endif
+    SDL_GL_SwapWindow(window);
+}
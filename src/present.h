@@ -0,0 +1,39 @@
+#ifndef PRESENT_H
+#define PRESENT_H
+
+#include "damage.h"
+
+#include <vector>
+
+struct SDL_Window;
+
+/*
+ * Presents only the damaged parts of the window when the context runs on EGL
+ * with EGL_EXT_buffer_age (or EGL_KHR_partial_update), using
+ * EGL_KHR_swap_buffers_with_damage when the driver has it. Everywhere else
+ * bufferAge() is 0, so callers redraw fully, and swaps go through SDL.
+ */
+class DamagePresenter {
+public:
+    /* Call with the window's context current. */
+    void init();
+
+    /* Frames since the back buffer was last presented, 0 if unknown. */
+    int bufferAge() const;
+    /* Tells tiled GPUs which parts will be drawn; call before any drawing. */
+    void setDamageRegion(const std::vector<DamageRect> &rects) const;
+    /*
+     * rects are what changed since the last presented frame, not the buffer
+     * age region; an empty rects presents the whole window.
+     */
+    void swap(SDL_Window *window, const std::vector<DamageRect> &rects) const;
+
+private:
+    void *mDisplay {nullptr};
+    void *mSurface {nullptr};
+    bool mBufferAge {false};
+    void *mSetDamageRegion {nullptr};
+    void *mSwapWithDamage {nullptr};
+};
+
+#endif    // PRESENT_H
@@ -0,0 +1,38 @@
+#include "program.h"
+
+#include <vector>
+
+void ProgramReflection::reflect(GLuint program)
+{
+    mLocations.clear();
+
+    GLint count = 0;
+    GLint maxLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::vector<GLchar> name(static_cast<std::size_t>(maxLength) + 1);
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = GL_NONE;
+        glGetActiveUniform(program, static_cast<GLuint>(i), static_cast<GLsizei>(name.size()), &length, &size, &type, name.data());
+
+        // Block members have no location; they are set through their buffer.
+        GLint location = glGetUniformLocation(program, name.data());
+        if (location < 0)
+            continue;
+
+        std::string uniform(name.data(), static_cast<std::size_t>(length));
+        // Arrays are reported as "name[0]"; make them reachable by "name" too.
+        if (uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0)
+            mLocations[uniform.substr(0, uniform.size() - 3)] = location;
+        mLocations[uniform] = location;
+    }
+}
+
+GLint ProgramReflection::location(const std::string &name) const
+{
+    auto it = mLocations.find(name);
+    return it == mLocations.end() ? -1 : it->second;
+}
@@ -0,0 +1,46 @@
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+#include "app_gl.h"
+
+#include <string>
+#include <unordered_map>
+
+/* Binding points fixed in the shaders with layout(binding = N). */
+static constexpr GLuint kCameraBinding {0};
+static constexpr GLuint kLogoTextureUnit {0};
+/* Shader storage block the sprite shaders pull their per-sprite data from. */
+static constexpr GLuint kSpriteBufferBinding {0};
+/* Explicit location of instanced_vert.glsl's instanceBase uniform. */
+static constexpr GLint kInstanceBaseLocation {0};
+/* Per-instance attributes of instanced_es_vert.glsl, all read from one vertex buffer binding. */
+static constexpr GLuint kSpriteVertexBinding {0};
+static constexpr GLuint kSpriteRectLocation {0};
+static constexpr GLuint kSpriteUvLocation {1};
+static constexpr GLuint kSpriteLayerLocation {2};
+static constexpr GLuint kSpriteTintLocation {3};
+/* Per-instance position attribute of gl33_vert.glsl, which has no storage buffers to pull from. */
+static constexpr GLuint kLogoPositionLocation {0};
+
+/* std140 layout of the Camera uniform block. */
+struct CameraBlock {
+    float view[16];
+    float projection[16];
+};
+
+/*
+ * Uniform locations of a linked program, gathered once after linking so the
+ * render loop never has to ask the driver by name.
+ */
+class ProgramReflection {
+public:
+    void reflect(GLuint program);
+
+    /* Location of a default-block uniform, or -1 if it is not active. */
+    GLint location(const std::string &name) const;
+
+private:
+    std::unordered_map<std::string, GLint> mLocations;
+};
+
+#endif    // PROGRAM_H
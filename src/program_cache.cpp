@@ -0,0 +1,304 @@
+#include "program_cache.h"
+
+#include "util.h"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static constexpr char kCacheMagic[8] {'D', 'V', 'D', 'P', 'R', 'O', 'G', '1'};
+
+/* FNV-1a; sources are a few KB, so one lane is plenty. */
+static std::uint64_t hashBytes(std::uint64_t hash, const std::string &bytes)
+{
+    constexpr std::uint64_t kPrime {0x100000001b3ull};
+    for (unsigned char byte : bytes)
+        hash = (hash ^ byte) * kPrime;
+    // Ends every string, so ("ab", "c") and ("a", "bc") differ.
+    return (hash ^ 0xff) * kPrime;
+}
+
+static std::string glString(GLenum name)
+{
+    const auto *value = reinterpret_cast<const char *>(glGetString(name));
+    return value ? value : "";
+}
+
+static bool readCache(const std::string &path, const std::string &driver, GLenum &format, std::vector<char> &binary)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    char magic[sizeof(kCacheMagic)];
+    std::uint32_t header[3];
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char *>(header), sizeof(header));
+    if (!file || std::memcmp(magic, kCacheMagic, sizeof(magic)) != 0 || header[0] != driver.size())
+        return false;
+
+    std::string storedDriver(header[0], '\0');
+    file.read(storedDriver.data(), static_cast<std::streamsize>(storedDriver.size()));
+    if (!file || storedDriver != driver)
+        return false;
+
+    format = header[1];
+    binary.resize(header[2]);
+    file.read(binary.data(), static_cast<std::streamsize>(binary.size()));
+    return static_cast<bool>(file);
+}
+
+static void writeCache(const std::string &path, const std::string &driver, GLenum format, const std::vector<char> &binary)
+{
+    // Write then rename, as the mip cache does.
+    const std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        const std::uint32_t header[3] {static_cast<std::uint32_t>(driver.size()), format, static_cast<std::uint32_t>(binary.size())};
+        file.write(kCacheMagic, sizeof(kCacheMagic));
+        file.write(reinterpret_cast<const char *>(header), sizeof(header));
+        file.write(driver.data(), static_cast<std::streamsize>(driver.size()));
+        file.write(binary.data(), static_cast<std::streamsize>(binary.size()));
+        if (!file)
+            return;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+}
+
+/* "vert.glsl + frag.glsl [TEXTURE_ARRAY]", for the trace. */
+static std::string programName(const ProgramDesc &desc)
+{
+    std::string name;
+    std::string defines;
+    for (const ShaderStage &stage : desc.stages) {
+        name += (name.empty() ? "" : " + ") + stage.path;
+        if (defines.empty())
+            defines = stage.defines;
+    }
+
+    std::string flags;
+    std::istringstream lines(defines);
+    for (std::string line; std::getline(lines, line);) {
+        if (line.rfind("#define ", 0) == 0)
+            flags += (flags.empty() ? "" : " ") + line.substr(8);
+    }
+    return flags.empty() ? name : name + " [" + flags + "]";
+}
+
+ProgramCache::~ProgramCache()
+{
+    destroy();
+}
+
+void ProgramCache::init(const std::string &dir, bool trace)
+{
+    destroy();
+
+    mDir.clear();
+    mTrace = trace;
+    mDriver = glString(GL_VENDOR) + "\n" + glString(GL_RENDERER) + "\n" + glString(GL_VERSION);
+
+    // Drivers may support the calls and still offer no format to save in.
+    // They need GL 4.1 or GLES 3.0; a 3.3 context may lack them.
+    GLint formats = 0;
+    if (glIsEs() || glVersionAtLeast(4, 1) || GLEW_ARB_get_program_binary)
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats > 0)
+        mDir = dir;
+
+    // As many compiler threads as the driver will give.
+    mParallel = false;
+    if (GLEW_KHR_parallel_shader_compile && glMaxShaderCompilerThreadsKHR) {
+        glMaxShaderCompilerThreadsKHR(0xffffffffu);
+        mParallel = true;
+    }
+    else if (GLEW_ARB_parallel_shader_compile && glMaxShaderCompilerThreadsARB) {
+        glMaxShaderCompilerThreadsARB(0xffffffffu);
+        mParallel = true;
+    }
+}
+
+void ProgramCache::destroy()
+{
+    for (auto &entry : mPending) {
+        for (GLuint shader : entry.second.shaders)
+            glDeleteShader(shader);
+        glDeleteProgram(entry.second.program);
+    }
+    mPending.clear();
+}
+
+bool ProgramCache::parallel() const
+{
+    return mParallel;
+}
+
+std::uint64_t ProgramCache::key(const ProgramDesc &desc, std::vector<std::string> &sources) const
+{
+    sources.clear();
+    std::uint64_t hash = hashBytes(0xcbf29ce484222325ull, mDriver);
+    for (const ShaderStage &stage : desc.stages) {
+        sources.push_back(loadShaderSource(stage.path, stage.defines));
+        hash = hashBytes(hash, std::to_string(stage.type));
+        hash = hashBytes(hash, sources.back());
+    }
+    for (const std::string &varying : desc.feedbackVaryings)
+        hash = hashBytes(hash, varying);
+    return hash;
+}
+
+void ProgramCache::prepare(const ProgramDesc &desc)
+{
+    std::vector<std::string> sources;
+    const std::uint64_t hash = key(desc, sources);
+    if (!mPending.count(hash))
+        start(hash, desc, sources);
+}
+
+void ProgramCache::start(std::uint64_t hash, const ProgramDesc &desc, const std::vector<std::string> &sources)
+{
+    Pending pending;
+    pending.name = programName(desc);
+    pending.start = Clock::now();
+
+    if (!mDir.empty()) {
+        std::stringstream name;
+        name << std::hex << hash << ".program";
+        pending.cachePath = (std::filesystem::path(mDir) / name.str()).string();
+
+        // Whether the driver takes it is only known from the link status,
+        // which build() asks for.
+        GLenum format = GL_NONE;
+        std::vector<char> binary;
+        if (readCache(pending.cachePath, mDriver, format, binary)) {
+            pending.program = glCreateProgram();
+            glProgramBinary(pending.program, format, binary.data(), static_cast<GLsizei>(binary.size()));
+            mPending.emplace(hash, std::move(pending));
+            return;
+        }
+    }
+
+    issueCompile(pending, desc, sources);
+    mPending.emplace(hash, std::move(pending));
+}
+
+bool ProgramCache::ready()
+{
+    // Without the extension any status query would block, so there is
+    // nothing to poll.
+    if (!mParallel)
+        return true;
+
+    bool ready = true;
+    for (auto &entry : mPending) {
+        Pending &pending = entry.second;
+        if (pending.readyMs >= 0.0)
+            continue;
+        GLint done = GL_FALSE;
+        glGetProgramiv(pending.program, GL_COMPLETION_STATUS_KHR, &done);
+        if (done)
+            pending.readyMs = std::chrono::duration<double, std::milli>(Clock::now() - pending.start).count();
+        else
+            ready = false;
+    }
+    return ready;
+}
+
+GLuint ProgramCache::build(const ProgramDesc &desc)
+{
+    std::vector<std::string> sources;
+    const std::uint64_t hash = key(desc, sources);
+    if (!mPending.count(hash))
+        start(hash, desc, sources);
+    auto it = mPending.find(hash);
+    Pending pending = std::move(it->second);
+    mPending.erase(it);
+
+    // Waits for the driver if it is still compiling.
+    bool cached = pending.shaders.empty();
+    GLint linked = GL_FALSE;
+    glGetProgramiv(pending.program, GL_LINK_STATUS, &linked);
+    if (cached && !linked) {
+        // Rejected; build from source and overwrite the entry.
+        glDeleteProgram(pending.program);
+        cached = false;
+        issueCompile(pending, desc, sources);
+        glGetProgramiv(pending.program, GL_LINK_STATUS, &linked);
+    }
+
+    // A compile error only shows up as a failed link; report the shader's
+    // own log rather than the linker's.
+    for (std::size_t i = 0; !linked && i < pending.shaders.size(); i++) {
+        GLint compiled = GL_FALSE;
+        glGetShaderiv(pending.shaders[i], GL_COMPILE_STATUS, &compiled);
+        if (compiled)
+            continue;
+        for (std::size_t other = 0; other < pending.shaders.size(); other++) {
+            if (other != i)
+                glDeleteShader(pending.shaders[other]);
+        }
+        glDeleteProgram(pending.program);
+        checkShader(pending.shaders[i], desc.stages[i].path);
+    }
+    for (GLuint shader : pending.shaders)
+        glDeleteShader(shader);
+    checkProgram(pending.program);
+
+    if (!cached && !pending.cachePath.empty())
+        storeBinary(pending);
+
+    if (mTrace) {
+        const double ms = pending.readyMs >= 0.0 ? pending.readyMs : std::chrono::duration<double, std::milli>(Clock::now() - pending.start).count();
+        std::cout << "program " << pending.name << ": " << ms << " ms, " << (cached ? "cached" : "compiled") << std::endl;
+    }
+    return pending.program;
+}
+
+void ProgramCache::issueCompile(Pending &pending, const ProgramDesc &desc, const std::vector<std::string> &sources)
+{
+    // Nothing here asks for a result, so none of it waits on the compiler.
+    pending.program = glCreateProgram();
+    pending.shaders.clear();
+    for (std::size_t i = 0; i < desc.stages.size(); i++) {
+        const char *source = sources[i].c_str();
+        GLuint shader = glCreateShader(desc.stages[i].type);
+        glShaderSource(shader, 1, &source, nullptr);
+        glCompileShader(shader);
+        glAttachShader(pending.program, shader);
+        pending.shaders.push_back(shader);
+    }
+
+    if (!desc.feedbackVaryings.empty()) {
+        std::vector<const char *> varyings;
+        for (const std::string &varying : desc.feedbackVaryings)
+            varyings.push_back(varying.c_str());
+        glTransformFeedbackVaryings(pending.program, static_cast<GLsizei>(varyings.size()), varyings.data(), GL_INTERLEAVED_ATTRIBS);
+    }
+    if (!pending.cachePath.empty())
+        glProgramParameteri(pending.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(pending.program);
+}
+
+void ProgramCache::storeBinary(const Pending &pending) const
+{
+    GLint length = 0;
+    glGetProgramiv(pending.program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary(static_cast<std::size_t>(length));
+    GLenum format = GL_NONE;
+    glGetProgramBinary(pending.program, length, &length, &format, binary.data());
+    binary.resize(static_cast<std::size_t>(length));
+
+    std::error_code error;
+    std::filesystem::create_directories(mDir, error);
+    // The cache is only an optimisation; failing to write it is not an error.
+    if (!error)
+        writeCache(pending.cachePath, mDriver, format, binary);
+}
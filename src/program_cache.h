@@ -0,0 +1,88 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include "app_gl.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* One shader of a program; defines go right after the #version line. */
+struct ShaderStage {
+    GLenum type;
+    std::string path;
+    std::string defines {};
+};
+
+struct ProgramDesc {
+    std::vector<ShaderStage> stages;
+    /* Transform feedback outputs, captured interleaved. */
+    std::vector<std::string> feedbackVaryings {};
+};
+
+/*
+ * Builds programs, keeping their glGetProgramBinary() output in a directory
+ * so later starts skip compiling and linking. Entries are named by a hash
+ * of the sources and GL vendor, renderer and version; a binary the driver
+ * rejects (e.g. after an update that kept the version string) is rebuilt
+ * from source and replaced.
+ *
+ * prepare() issues a program's compile and link without asking for the
+ * result. With GL_KHR_parallel_shader_compile the driver works on every
+ * prepared program at once on its own threads, and ready() polls
+ * GL_COMPLETION_STATUS_KHR so the caller can keep drawing meanwhile.
+ * Without it the driver compiles when the result is first asked for, in
+ * build().
+ */
+class ProgramCache {
+public:
+    ~ProgramCache();
+
+    /*
+     * An empty dir, or a driver with no binary formats, always compiles.
+     * trace prints each program's build time as build() hands it out.
+     */
+    void init(const std::string &dir, bool trace = false);
+    /* Deletes programs that were prepared but never built. */
+    void destroy();
+
+    bool parallel() const;
+
+    /* Starts building desc, unless it is already on its way. */
+    void prepare(const ProgramDesc &desc);
+    /* True once no prepared program is still compiling; never waits. */
+    bool ready();
+
+    /* Linked program for desc; throws if it fails to compile or link. */
+    GLuint build(const ProgramDesc &desc);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Pending {
+        GLuint program {GL_NONE};
+        /* Empty when loaded from a cached binary. */
+        std::vector<GLuint> shaders;
+        std::string cachePath;
+        std::string name;
+        Clock::time_point start;
+        /* Set by ready() once the driver reports completion. */
+        double readyMs {-1.0};
+    };
+
+    std::uint64_t key(const ProgramDesc &desc, std::vector<std::string> &sources) const;
+    void start(std::uint64_t hash, const ProgramDesc &desc, const std::vector<std::string> &sources);
+    void issueCompile(Pending &pending, const ProgramDesc &desc, const std::vector<std::string> &sources);
+    void storeBinary(const Pending &pending) const;
+
+    std::string mDir;
+    /* Vendor, renderer and version; a binary only loads on the same driver. */
+    std::string mDriver;
+    bool mTrace {false};
+    bool mParallel {false};
+    std::unordered_map<std::uint64_t, Pending> mPending;
+};
+
+#endif    // PROGRAM_CACHE_H
@@ -0,0 +1,67 @@
+#include "soft_backend.h"
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+#ifdef __linux__
+#include <SDL2/SDL.h>
+#else
+#include <SDL.h>
+#endif
+
+SoftBackend::~SoftBackend()
+{
+    if (mSdlTexture)
+        SDL_DestroyTexture(mSdlTexture);
+    if (mSdlRenderer)
+        SDL_DestroyRenderer(mSdlRenderer);
+}
+
+void SoftBackend::init(SDL_Window *window, int width, int height, std::uint32_t clearColour)
+{
+    mRenderer.init(width, height);
+    mClearColour = clearColour;
+
+    if (!window)
+        return;
+
+    mSdlRenderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_PRESENTVSYNC);
+    if (!mSdlRenderer)
+        throw std::runtime_error(std::string("Failed to make SDL renderer: ") + SDL_GetError());
+    mSdlTexture = SDL_CreateTexture(mSdlRenderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, width, height);
+    if (!mSdlTexture)
+        throw std::runtime_error(std::string("Failed to make SDL texture: ") + SDL_GetError());
+}
+
+void SoftBackend::setImages(const std::vector<Image> &images)
+{
+    mRenderer.setImages(images);
+}
+
+void SoftBackend::setScale(float scale)
+{
+    mRenderer.setScale(scale);
+}
+
+void SoftBackend::drawFrame(const Logos &logos, FrameStats &stats)
+{
+    auto start = std::chrono::steady_clock::now();
+    mRenderer.render(logos, mClearColour);
+    stats.submitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    stats.instances = logos.size();
+
+    const Image &frame = mRenderer.framebuffer();
+    stats.redrawnPixels = static_cast<std::size_t>(frame.width) * frame.height;
+
+    if (mSdlRenderer) {
+        SDL_UpdateTexture(mSdlTexture, nullptr, frame.pixels.data(), frame.width * 4);
+        SDL_RenderCopy(mSdlRenderer, mSdlTexture, nullptr, nullptr);
+        SDL_RenderPresent(mSdlRenderer);
+    }
+}
+
+Image SoftBackend::capture()
+{
+    return mRenderer.framebuffer();
+}
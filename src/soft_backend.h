@@ -0,0 +1,36 @@
+#ifndef SOFT_BACKEND_H
+#define SOFT_BACKEND_H
+
+#include "logo_backend.h"
+#include "soft_renderer.h"
+
+#include <cstdint>
+
+struct SDL_Renderer;
+struct SDL_Texture;
+struct SDL_Window;
+
+/*
+ * SoftRenderer frames copied into a streaming SDL texture; SDL falls back to
+ * its own software renderer when there is no GPU driver.
+ */
+class SoftBackend : public LogoBackend {
+public:
+    ~SoftBackend() override;
+
+    /* clearColour is RGBA8, red in the lowest byte. */
+    void init(SDL_Window *window, int width, int height, std::uint32_t clearColour);
+
+    void setImages(const std::vector<Image> &images) override;
+    void setScale(float scale) override;
+    void drawFrame(const Logos &logos, FrameStats &stats) override;
+    Image capture() override;
+
+private:
+    SoftRenderer mRenderer;
+    std::uint32_t mClearColour {0};
+    SDL_Renderer *mSdlRenderer {nullptr};
+    SDL_Texture *mSdlTexture {nullptr};
+};
+
+#endif    // SOFT_BACKEND_H
@@ -0,0 +1,51 @@
+#include "golden.h"
+#include "headless.h"
+#include "soft_backend.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+/*
+ * Renders the golden scene with SoftBackend and compares it with the GL
+ * instanced renderer on a headless context (llvmpipe is enough). Run from
+ * the assets directory; exits non-zero on a mismatch.
+ *
+ * Usage: dvd-soft-check [logos]
+ */
+
+// Filtering and blending round differently by a few steps; a wrong image,
+// texel or blend is off by far more.
+static constexpr int kTolerance {16};
+
+int main(int argc, char **argv)
+{
+    try {
+        const std::size_t count = argc > 1 ? std::stoul(argv[1]) : 2000;
+
+        const GoldenScene scene = goldenScene(count);
+
+        HeadlessContext context;
+        context.init(kGoldenWidth, kGoldenHeight);
+        const Image reference = renderGolden(scene);
+        context.destroy();
+
+        SoftBackend software;
+        software.init(nullptr, kGoldenWidth, kGoldenHeight, kGoldenClearColour);
+        software.setImages(scene.images);
+        software.setScale(kGoldenScale);
+        FrameStats stats;
+        software.drawFrame(scene.logos, stats);
+
+        const int difference = maxChannelDifference(reference, software.capture());
+        std::cout << count << " logos, " << SoftRenderer::simdPath() << " blend: max channel difference " << difference << " (tolerance "
+                  << kTolerance << ")" << std::endl;
+        return difference <= kTolerance ? 0 : 1;
+    } catch (const std::logic_error &) {
+        std::cerr << "Usage: dvd-soft-check [logos]" << std::endl;
+        return 1;
+    } catch (const std::runtime_error &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
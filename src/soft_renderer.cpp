@@ -0,0 +1,478 @@
+#include "soft_renderer.h"
+
+#include "mipmap.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+// GCC and Clang can build an AVX2 loop into an SSE2 binary and pick it at run
+// time; elsewhere the build flags decide.
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#define SOFT_RENDERER_AVX2
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+// Bilinear weights carry 7 bits so (b - a) * w stays inside a signed 16-bit lane.
+static constexpr int kWeightBits {7};
+
+/*
+ * One row of a sprite within a tile: count pixels from dst, sampling rows
+ * row0 and row1 of a level at 16.16 texel coordinate u, stepping du per
+ * pixel. The level's border makes texel lastTexel + 1 safe to read.
+ */
+struct Span {
+    std::uint32_t *dst;
+    int count;
+    std::int32_t u;
+    std::int32_t du;
+    const std::uint32_t *row0;
+    const std::uint32_t *row1;
+    int weightY;
+    int lastTexel;
+};
+
+/* The loops below all round alike, so every one draws the same bytes. */
+struct BlendPath {
+    const char *name;
+    void (*blend)(const Span &span);
+};
+
+#ifndef __SSE2__
+/* One channel of the SIMD paths, with the same rounding. */
+static int lerpChannel(int a, int b, int weight)
+{
+    return a + (((b - a) * weight) >> kWeightBits);
+}
+
+static void blendSpanScalar(const Span &span)
+{
+    std::int32_t u = span.u;
+    for (int i = 0; i < span.count; i++, u += span.du) {
+        const int texel = std::min(u >> 16, span.lastTexel);
+        const int weightX = (u >> (16 - kWeightBits)) & ((1 << kWeightBits) - 1);
+        const auto *above = reinterpret_cast<const unsigned char *>(span.row0 + texel);
+        const auto *below = reinterpret_cast<const unsigned char *>(span.row1 + texel);
+        auto *out = reinterpret_cast<unsigned char *>(span.dst + i);
+        int src[4];
+        for (int c = 0; c < 4; c++) {
+            const int left = lerpChannel(above[c], below[c], span.weightY);
+            const int right = lerpChannel(above[c + 4], below[c + 4], span.weightY);
+            src[c] = lerpChannel(left, right, weightX);
+        }
+
+        // Premultiplied over, as in overSse2().
+        const int inverseAlpha = 255 - src[3];
+        for (int c = 0; c < 4; c++) {
+            const int scaled = out[c] * inverseAlpha + 128;
+            out[c] = static_cast<unsigned char>(std::min(src[c] + ((scaled + (scaled >> 8)) >> 8), 255));
+        }
+    }
+}
+#endif
+
+/* numerator / denominator rounded up, for a positive denominator. */
+static std::int64_t ceilDivide(std::int64_t numerator, std::int64_t denominator)
+{
+    return numerator > 0 ? (numerator + denominator - 1) / denominator : -(-numerator / denominator);
+}
+
+#ifdef __SSE2__
+/* a + (b - a) * weight, per 16-bit channel. */
+static inline __m128i lerpSse2(__m128i a, __m128i b, __m128i weight)
+{
+    return _mm_add_epi16(a, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(b, a), weight), kWeightBits));
+}
+
+/*
+ * Premultiplied over per 16-bit channel: src + dst * (255 - srcAlpha) / 255,
+ * with the divide done as (n + 128 + ((n + 128) >> 8)) >> 8.
+ */
+static inline __m128i overSse2(__m128i src, __m128i dst)
+{
+    const __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    __m128i scaled = _mm_add_epi16(_mm_mullo_epi16(dst, _mm_sub_epi16(_mm_set1_epi16(255), alpha)), _mm_set1_epi16(128));
+    scaled = _mm_srli_epi16(_mm_add_epi16(scaled, _mm_srli_epi16(scaled, 8)), 8);
+    return _mm_add_epi16(src, scaled);
+}
+
+/* Bilinear samples for two pixels whose 2x2 blocks start at texels a and b, as 16-bit channels. */
+static inline __m128i samplePairSse2(const Span &span, int a, int b, __m128i fy, __m128i fx)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i above = _mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(span.row0 + a)),
+                                             _mm_loadl_epi64(reinterpret_cast<const __m128i *>(span.row0 + b)));
+    const __m128i below = _mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(span.row1 + a)),
+                                             _mm_loadl_epi64(reinterpret_cast<const __m128i *>(span.row1 + b)));
+
+    // Lerp the rows of each block, leaving each pixel's left and right
+    // texels in one register, then gather the lefts and rights to lerp those.
+    const __m128i first = lerpSse2(_mm_unpacklo_epi8(above, zero), _mm_unpacklo_epi8(below, zero), fy);
+    const __m128i second = lerpSse2(_mm_unpackhi_epi8(above, zero), _mm_unpackhi_epi8(below, zero), fy);
+    return lerpSse2(_mm_unpacklo_epi64(first, second), _mm_unpackhi_epi64(first, second), fx);
+}
+
+/* Blends four pixels at dst, the first sampled at u; steps holds 0 to 3 times du. */
+static inline void blendFourSse2(const Span &span, std::int32_t u, std::uint32_t *dst, __m128i steps, __m128i fy)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lastTexel = _mm_set1_epi32(span.lastTexel);
+    const __m128i us = _mm_add_epi32(_mm_set1_epi32(u), steps);
+
+    // SSE2 has no 32-bit min.
+    const __m128i texels = _mm_srai_epi32(us, 16);
+    const __m128i clamp = _mm_cmpgt_epi32(texels, lastTexel);
+    alignas(16) std::int32_t texel[4];
+    _mm_store_si128(reinterpret_cast<__m128i *>(texel), _mm_or_si128(_mm_andnot_si128(clamp, texels), _mm_and_si128(clamp, lastTexel)));
+
+    // Each pixel's weight spread over its four channels, two pixels per register.
+    __m128i weights = _mm_and_si128(_mm_srai_epi32(us, 16 - kWeightBits), _mm_set1_epi32((1 << kWeightBits) - 1));
+    weights = _mm_packs_epi32(weights, weights);
+    weights = _mm_unpacklo_epi16(weights, weights);
+    const __m128i src01 = samplePairSse2(span, texel[0], texel[1], fy, _mm_unpacklo_epi32(weights, weights));
+    const __m128i src23 = samplePairSse2(span, texel[2], texel[3], fy, _mm_unpackhi_epi32(weights, weights));
+
+    // Over with nothing leaves dst exactly as it was.
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_or_si128(src01, src23), zero)) == 0xffff)
+        return;
+
+    auto *pixels = reinterpret_cast<__m128i *>(dst);
+    const __m128i background = _mm_loadu_si128(pixels);
+    _mm_storeu_si128(pixels, _mm_packus_epi16(overSse2(src01, _mm_unpacklo_epi8(background, zero)), overSse2(src23, _mm_unpackhi_epi8(background, zero))));
+}
+
+/* Four pixels per iteration. */
+static void blendSpanSse2(const Span &span)
+{
+    const __m128i fy = _mm_set1_epi16(static_cast<short>(span.weightY));
+    const __m128i steps = _mm_setr_epi32(0, span.du, 2 * span.du, 3 * span.du);
+
+    int i = 0;
+    for (; i + 4 <= span.count; i += 4)
+        blendFourSse2(span, span.u + i * span.du, span.dst + i, steps, fy);
+
+    // The last few pixels go through a copy, so the group never writes past
+    // the span; texels past its end stay clamped inside the level.
+    if (i < span.count) {
+        std::uint32_t rest[4] {};
+        const std::size_t bytes = static_cast<std::size_t>(span.count - i) * sizeof(std::uint32_t);
+        std::memcpy(rest, span.dst + i, bytes);
+        blendFourSse2(span, span.u + i * span.du, rest, steps, fy);
+        std::memcpy(span.dst + i, rest, bytes);
+    }
+}
+#endif
+
+#ifdef SOFT_RENDERER_AVX2
+#define SOFT_RENDERER_TARGET_AVX2 __attribute__((target("avx2")))
+
+SOFT_RENDERER_TARGET_AVX2 static inline __m256i lerpAvx2(__m256i a, __m256i b, __m256i weight)
+{
+    return _mm256_add_epi16(a, _mm256_srai_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(b, a), weight), kWeightBits));
+}
+
+SOFT_RENDERER_TARGET_AVX2 static inline __m256i overAvx2(__m256i src, __m256i dst)
+{
+    const __m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(src, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    __m256i scaled = _mm256_add_epi16(_mm256_mullo_epi16(dst, _mm256_sub_epi16(_mm256_set1_epi16(255), alpha)), _mm256_set1_epi16(128));
+    scaled = _mm256_srli_epi16(_mm256_add_epi16(scaled, _mm256_srli_epi16(scaled, 8)), 8);
+    return _mm256_add_epi16(src, scaled);
+}
+
+/* One row of four pixels' 2x2 blocks, two pixels per 128-bit half. */
+SOFT_RENDERER_TARGET_AVX2 static inline __m256i blocksAvx2(const std::uint32_t *row, const std::int32_t *texel)
+{
+    const __m128i low = _mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(row + texel[0])),
+                                           _mm_loadl_epi64(reinterpret_cast<const __m128i *>(row + texel[1])));
+    const __m128i high = _mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(row + texel[2])),
+                                            _mm_loadl_epi64(reinterpret_cast<const __m128i *>(row + texel[3])));
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+}
+
+/*
+ * Bilinear samples for four pixels as 16-bit channels, in the order
+ * _mm256_cvtepu8_epi16 widens four framebuffer pixels. 256-bit unpacks
+ * work within 128-bit halves, so each half is samplePairSse2() on two
+ * pixels. Gathers would fetch the blocks in one instruction, but are
+ * microcoded and slower than these loads on most CPUs since the Downfall
+ * fix.
+ */
+SOFT_RENDERER_TARGET_AVX2 static inline __m256i sampleQuadAvx2(const Span &span, const std::int32_t *texel, __m128i weights, __m256i fy)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i above = blocksAvx2(span.row0, texel);
+    const __m256i below = blocksAvx2(span.row1, texel);
+
+    // Each pixel's weight, from the low byte of its 32-bit lane, spread over
+    // its four 16-bit channels.
+    const __m256i spread = _mm256_setr_epi8(0, -128, 0, -128, 0, -128, 0, -128, 4, -128, 4, -128, 4, -128, 4, -128,
+                                            8, -128, 8, -128, 8, -128, 8, -128, 12, -128, 12, -128, 12, -128, 12, -128);
+    const __m256i fx = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(weights), spread);
+
+    const __m256i first = lerpAvx2(_mm256_unpacklo_epi8(above, zero), _mm256_unpacklo_epi8(below, zero), fy);
+    const __m256i second = lerpAvx2(_mm256_unpackhi_epi8(above, zero), _mm256_unpackhi_epi8(below, zero), fy);
+    return lerpAvx2(_mm256_unpacklo_epi64(first, second), _mm256_unpackhi_epi64(first, second), fx);
+}
+
+/* Blends eight pixels at dst, the first sampled at u; steps holds 0 to 7 times du. */
+SOFT_RENDERER_TARGET_AVX2 static inline void blendEightAvx2(const Span &span, std::int32_t u, std::uint32_t *dst, __m256i steps, __m256i fy)
+{
+    const __m256i us = _mm256_add_epi32(_mm256_set1_epi32(u), steps);
+    alignas(32) std::int32_t texel[8];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(texel), _mm256_min_epi32(_mm256_srai_epi32(us, 16), _mm256_set1_epi32(span.lastTexel)));
+    const __m256i weights = _mm256_and_si256(_mm256_srai_epi32(us, 16 - kWeightBits), _mm256_set1_epi32((1 << kWeightBits) - 1));
+    const __m256i src0 = sampleQuadAvx2(span, texel, _mm256_castsi256_si128(weights), fy);
+    const __m256i src1 = sampleQuadAvx2(span, texel + 4, _mm256_extracti128_si256(weights, 1), fy);
+
+    const __m256i any = _mm256_or_si256(src0, src1);
+    if (_mm256_testz_si256(any, any))
+        return;
+
+    auto *pixels = reinterpret_cast<__m256i *>(dst);
+    const __m256i background = _mm256_loadu_si256(pixels);
+    const __m256i out0 = overAvx2(src0, _mm256_cvtepu8_epi16(_mm256_castsi256_si128(background)));
+    const __m256i out1 = overAvx2(src1, _mm256_cvtepu8_epi16(_mm256_extracti128_si256(background, 1)));
+    // The pack also works per half, leaving pixels 0-1, 4-5, 2-3, 6-7.
+    _mm256_storeu_si256(pixels, _mm256_permute4x64_epi64(_mm256_packus_epi16(out0, out1), _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+/* Eight pixels per iteration; the tail as in blendSpanSse2(). */
+SOFT_RENDERER_TARGET_AVX2 static void blendSpanAvx2(const Span &span)
+{
+    const __m256i fy = _mm256_set1_epi16(static_cast<short>(span.weightY));
+    const __m256i steps = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(span.du));
+
+    int i = 0;
+    for (; i + 8 <= span.count; i += 8)
+        blendEightAvx2(span, span.u + i * span.du, span.dst + i, steps, fy);
+
+    if (i < span.count) {
+        std::uint32_t rest[8] {};
+        const std::size_t bytes = static_cast<std::size_t>(span.count - i) * sizeof(std::uint32_t);
+        std::memcpy(rest, span.dst + i, bytes);
+        blendEightAvx2(span, span.u + i * span.du, rest, steps, fy);
+        std::memcpy(span.dst + i, rest, bytes);
+    }
+}
+#endif
+
+/* The widest loop this CPU runs, picked on first use. */
+static const BlendPath &blendPath()
+{
+    static const BlendPath path = [] {
+#ifdef SOFT_RENDERER_AVX2
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return BlendPath {"avx2", blendSpanAvx2};
+#endif
+#ifdef __SSE2__
+        return BlendPath {"sse2", blendSpanSse2};
+#else
+        return BlendPath {"scalar", blendSpanScalar};
+#endif
+    }();
+    return path;
+}
+
+const char *SoftRenderer::simdPath()
+{
+    return blendPath().name;
+}
+
+void SoftRenderer::init(int width, int height, unsigned threads)
+{
+    mWidth = width;
+    mHeight = height;
+    mColumns = (width + kTileSize - 1) / kTileSize;
+    mRows = (height + kTileSize - 1) / kTileSize;
+    mPool.init(threads);
+    mFramebuffer.width = width;
+    mFramebuffer.height = height;
+    mFramebuffer.pixels.assign(static_cast<std::size_t>(width) * height * 4, 0);
+    mBinStarts.assign(static_cast<std::size_t>(mColumns) * mRows + 1, 0);
+}
+
+void SoftRenderer::setImages(const std::vector<Image> &images)
+{
+    mImages.clear();
+    for (const Image &image : images) {
+        // Premultiply before building the mips, so transparent texels'
+        // colour never bleeds into their neighbours.
+        Image premultiplied = image;
+        premultiplyAlpha(premultiplied);
+
+        std::vector<Level> chain;
+        for (const Image &mip : buildMipChain(premultiplied)) {
+            // A border of repeated edge texels lets the sampler always read a
+            // 2x2 block without clamping, which is what GL_CLAMP_TO_EDGE gives.
+            Level level;
+            level.width = mip.width;
+            level.height = mip.height;
+            level.stride = mip.width + 2;
+            level.texels.resize(static_cast<std::size_t>(level.stride) * (mip.height + 2));
+            for (int y = 0; y < mip.height + 2; y++) {
+                const int srcY = std::min(std::max(y - 1, 0), mip.height - 1);
+                for (int x = 0; x < mip.width + 2; x++) {
+                    const int srcX = std::min(std::max(x - 1, 0), mip.width - 1);
+                    std::memcpy(&level.texels[static_cast<std::size_t>(y) * level.stride + x], mip.pixels.data() + (static_cast<std::size_t>(srcY) * mip.width + srcX) * 4, 4);
+                }
+            }
+
+            // A fully transparent premultiplied texel is all zero bits.
+            level.blocks.resize(static_cast<std::size_t>(mip.height) + 1);
+            for (int y = 0; y <= mip.height; y++) {
+                const std::uint32_t *above = level.texels.data() + static_cast<std::size_t>(y) * level.stride;
+                const std::uint32_t *below = above + level.stride;
+                int first = level.stride;
+                int last = -1;
+                for (int x = 0; x < level.stride; x++) {
+                    if (above[x] != 0 || below[x] != 0) {
+                        first = std::min(first, x);
+                        last = x;
+                    }
+                }
+                // The block at texel t also covers column t + 1.
+                level.blocks[static_cast<std::size_t>(y)] = {std::max(first - 1, 0), std::min(last, mip.width)};
+            }
+            chain.push_back(std::move(level));
+        }
+        mImages.push_back(std::move(chain));
+    }
+}
+
+void SoftRenderer::setScale(float scale)
+{
+    mScale = scale;
+}
+
+void SoftRenderer::render(const Logos &logos, std::uint32_t clearColour)
+{
+    mClearColour = clearColour;
+    mSprites.clear();
+    mSprites.reserve(logos.size());
+    std::fill(mBinStarts.begin(), mBinStarts.end(), 0);
+
+    for (std::size_t i = 0; i < logos.size(); i++) {
+        const std::vector<Level> &chain = mImages[logos.id[i] % mImages.size()];
+        const float width = static_cast<float>(chain.front().width) * mScale;
+        const float height = static_cast<float>(chain.front().height) * mScale;
+        const float left = logos.x[i] - width * 0.5f;
+        const float top = logos.y[i] - height * 0.5f;
+
+        // Pixels whose centres fall inside the quad, as GL rasterizes it.
+        Sprite sprite;
+        sprite.left = std::max(static_cast<int>(std::ceil(left - 0.5f)), 0);
+        sprite.top = std::max(static_cast<int>(std::ceil(top - 0.5f)), 0);
+        sprite.right = std::min(static_cast<int>(std::ceil(left + width - 0.5f)), mWidth);
+        sprite.bottom = std::min(static_cast<int>(std::ceil(top + height - 0.5f)), mHeight);
+        if (sprite.left >= sprite.right || sprite.top >= sprite.bottom)
+            continue;
+
+        // Nearest mip level to the minification; GL blends the two nearest.
+        const float lod = std::log2(std::max(1.0f / mScale, 1.0f));
+        const int levelIndex = std::min(static_cast<int>(lod + 0.5f), static_cast<int>(chain.size()) - 1);
+        sprite.level = &chain[static_cast<std::size_t>(levelIndex)];
+
+        // Texel-space coordinates of the first pixel centre, shifted by one
+        // for the border and by half a texel to land on texel centres.
+        const float uScale = static_cast<float>(sprite.level->width) / width;
+        const float vScale = static_cast<float>(sprite.level->height) / height;
+        sprite.du = static_cast<std::int32_t>(uScale * 65536.0f);
+        sprite.dv = static_cast<std::int32_t>(vScale * 65536.0f);
+        sprite.u0 = static_cast<std::int32_t>(((static_cast<float>(sprite.left) + 0.5f - left) * uScale + 0.5f) * 65536.0f);
+        sprite.v0 = static_cast<std::int32_t>(((static_cast<float>(sprite.top) + 0.5f - top) * vScale + 0.5f) * 65536.0f);
+
+        mSprites.push_back(sprite);
+        for (int row = sprite.top / kTileSize; row <= (sprite.bottom - 1) / kTileSize; row++) {
+            for (int column = sprite.left / kTileSize; column <= (sprite.right - 1) / kTileSize; column++)
+                mBinStarts[static_cast<std::size_t>(row) * mColumns + column + 1]++;
+        }
+    }
+
+    // Bins are runs of one array, placed by a prefix sum over their sizes,
+    // then filled in draw order.
+    const int tiles = mColumns * mRows;
+    for (int tile = 0; tile < tiles; tile++)
+        mBinStarts[static_cast<std::size_t>(tile) + 1] += mBinStarts[static_cast<std::size_t>(tile)];
+    mBinEntries.resize(mBinStarts.back());
+    mBinFill.assign(mBinStarts.begin(), mBinStarts.end() - 1);
+    for (std::size_t index = 0; index < mSprites.size(); index++) {
+        const Sprite &sprite = mSprites[index];
+        for (int row = sprite.top / kTileSize; row <= (sprite.bottom - 1) / kTileSize; row++) {
+            for (int column = sprite.left / kTileSize; column <= (sprite.right - 1) / kTileSize; column++)
+                mBinEntries[mBinFill[static_cast<std::size_t>(row) * mColumns + column]++] = static_cast<std::uint32_t>(index);
+        }
+    }
+
+    // Tiles vary a lot in cost, so threads take the next free one rather
+    // than a fixed share.
+    std::atomic<int> nextTile {0};
+    mPool.run(std::min(mPool.threads(), static_cast<unsigned>(tiles)), [&](unsigned) {
+        for (int tile = nextTile++; tile < tiles; tile = nextTile++)
+            drawTile(tile);
+    });
+}
+
+void SoftRenderer::drawTile(int tile)
+{
+    const int tileLeft = (tile % mColumns) * kTileSize;
+    const int tileTop = (tile / mColumns) * kTileSize;
+    const int tileRight = std::min(tileLeft + kTileSize, mWidth);
+    const int tileBottom = std::min(tileTop + kTileSize, mHeight);
+    auto *pixels = reinterpret_cast<std::uint32_t *>(mFramebuffer.pixels.data());
+
+    for (int y = tileTop; y < tileBottom; y++)
+        std::fill(pixels + static_cast<std::size_t>(y) * mWidth + tileLeft, pixels + static_cast<std::size_t>(y) * mWidth + tileRight, mClearColour);
+
+    const auto blend = blendPath().blend;
+    const std::uint32_t *binEnd = mBinEntries.data() + mBinStarts[static_cast<std::size_t>(tile) + 1];
+    for (const std::uint32_t *entry = mBinEntries.data() + mBinStarts[static_cast<std::size_t>(tile)]; entry != binEnd; entry++) {
+        const Sprite &sprite = mSprites[*entry];
+        const Level &level = *sprite.level;
+        const int left = std::max(sprite.left, tileLeft);
+        const int right = std::min(sprite.right, tileRight);
+        const int top = std::max(sprite.top, tileTop);
+        const int bottom = std::min(sprite.bottom, tileBottom);
+
+        Span span;
+        span.du = sprite.du;
+        span.lastTexel = level.width;
+        const std::int32_t u = sprite.u0 + (left - sprite.left) * sprite.du;
+        for (int y = top; y < bottom; y++) {
+            const std::int32_t v = sprite.v0 + (y - sprite.top) * sprite.dv;
+            const int row = std::min(v >> 16, level.height);
+
+            // Blending a fully transparent block leaves the pixel as it was,
+            // so trim the pixels whose blocks lie outside the row's extent.
+            // Texels only grow along the span, clamped to lastTexel.
+            const Extent &extent = level.blocks[static_cast<std::size_t>(row)];
+            if (extent.first > extent.last)
+                continue;
+            int begin = 0;
+            int end = right - left;
+            if ((u >> 16) < extent.first)
+                begin = static_cast<int>(ceilDivide((static_cast<std::int64_t>(extent.first) << 16) - u, sprite.du));
+            if (extent.last < span.lastTexel)
+                end = std::min(end, static_cast<int>(ceilDivide((static_cast<std::int64_t>(extent.last + 1) << 16) - u, sprite.du)));
+            if (begin >= end)
+                continue;
+
+            span.dst = pixels + static_cast<std::size_t>(y) * mWidth + left + begin;
+            span.count = end - begin;
+            span.u = u + begin * sprite.du;
+            span.row0 = level.texels.data() + static_cast<std::size_t>(row) * level.stride;
+            span.row1 = span.row0 + level.stride;
+            span.weightY = (v >> (16 - kWeightBits)) & ((1 << kWeightBits) - 1);
+            blend(span);
+        }
+    }
+}
+
+const Image &SoftRenderer::framebuffer() const
+{
+    return mFramebuffer;
+}
@@ -0,0 +1,96 @@
+#ifndef SOFT_RENDERER_H
+#define SOFT_RENDERER_H
+
+#include "logos.h"
+#include "util.h"
+#include "worker_pool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Draws logos into a CPU framebuffer with no GL at all, for machines without
+ * a driver. The screen is split into kTileSize tiles; logos are binned per
+ * tile in draw order and threads from a WorkerPool pull tiles from a shared
+ * counter, so no two threads ever touch the same pixel. Sampling is bilinear
+ * from premultiplied mip chains (nearest level), blending is premultiplied
+ * "over". Each sprite row is blended 8 pixels at a time with AVX2 when the
+ * CPU has it, else 4 at a time with SSE2 where the target has it, else in
+ * plain C++; all three draw the same bytes. Matches the GL path to within a
+ * few levels per channel, the difference being GL's blend between the two
+ * nearest mip levels.
+ */
+class SoftRenderer {
+public:
+    static constexpr int kTileSize {64};
+
+    /* threads 0 uses every hardware thread. */
+    void init(int width, int height, unsigned threads = 0);
+    /* A logo shows image id % images. */
+    void setImages(const std::vector<Image> &images);
+    /* Multiplies every logo's drawn size; 1 draws images at their own size. */
+    void setScale(float scale);
+
+    void render(const Logos &logos, std::uint32_t clearColour);
+
+    /* RGBA8, top row first; what render() drew last. */
+    const Image &framebuffer() const;
+
+    /* The blend loop this CPU runs: "avx2", "sse2" or "scalar". */
+    static const char *simdPath();
+
+private:
+    /* Texels first to last of a row, inclusive; empty when first > last. */
+    struct Extent {
+        int first;
+        int last;
+    };
+
+    /* One premultiplied mip level with a one-texel border of its own edge. */
+    struct Level {
+        int width {0};
+        int height {0};
+        int stride {0};
+        std::vector<std::uint32_t> texels;
+        /* Per row, the texels whose 2x2 block with the next row is not
+         * fully transparent; pixels sampling outside it are skipped. */
+        std::vector<Extent> blocks;
+    };
+
+    struct Sprite {
+        int left;
+        int top;
+        int right;
+        int bottom;
+        /* Texel coordinates of the first pixel centre and per-pixel steps, 16.16 fixed point. */
+        std::int32_t u0;
+        std::int32_t v0;
+        std::int32_t du;
+        std::int32_t dv;
+        const Level *level;
+    };
+
+    void drawTile(int tile);
+
+    int mWidth {0};
+    int mHeight {0};
+    int mColumns {0};
+    int mRows {0};
+    WorkerPool mPool;
+    float mScale {1.0f};
+    std::uint32_t mClearColour {0};
+    Image mFramebuffer;
+
+    /* Mip chains, one per image. */
+    std::vector<std::vector<Level>> mImages;
+    std::vector<Sprite> mSprites;
+    /* Indices into mSprites, tile by tile and in draw order within a tile;
+     * tile t's run starts at mBinStarts[t] and ends at mBinStarts[t + 1].
+     * Kept across frames, so they only grow when a frame needs more. */
+    std::vector<std::uint32_t> mBinEntries;
+    std::vector<std::size_t> mBinStarts;
+    std::vector<std::size_t> mBinFill;
+};
+
+#endif    // SOFT_RENDERER_H
@@ -0,0 +1,221 @@
+#include "sprite_batch.h"
+
+#include "program.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cstddef>
+
+static constexpr int kProgramShift {48};
+static constexpr int kTextureShift {32};
+static constexpr int kBlendShift {28};
+static constexpr int kDepthShift {4};
+static constexpr std::uint64_t kStateMask {~((std::uint64_t {1} << kBlendShift) - 1)};
+
+SpriteBatch::~SpriteBatch()
+{
+    destroy();
+}
+
+void SpriteBatch::init(std::size_t capacity)
+{
+    destroy();
+
+    mCapacity = capacity;
+    mKeys.resize(capacity);
+    mKeysScratch.resize(capacity);
+    mOrder.resize(capacity);
+    mOrderScratch.resize(capacity);
+
+    // Regions hold a whole number of instances, so each draw can select its
+    // run with an index offset instead of rebinding the buffer.
+    mStream.init(capacity * sizeof(LogoInstance));
+
+    mInstanceAttributes = glIsEs();
+    if (!mInstanceAttributes) {
+        // The shaders pull everything from the storage buffer; core profile
+        // still wants some vertex array bound to draw.
+        glCreateVertexArrays(1, &mVao);
+        return;
+    }
+
+    // The buffer itself is bound per run in flush().
+    glGenVertexArrays(1, &mVao);
+    glBindVertexArray(mVao);
+    glVertexAttribFormat(kSpriteRectLocation, 4, GL_FLOAT, GL_FALSE, offsetof(LogoInstance, x));
+    glVertexAttribFormat(kSpriteUvLocation, 4, GL_FLOAT, GL_FALSE, offsetof(LogoInstance, u0));
+    glVertexAttribFormat(kSpriteLayerLocation, 1, GL_FLOAT, GL_FALSE, offsetof(LogoInstance, layer));
+    glVertexAttribFormat(kSpriteTintLocation, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(LogoInstance, tint));
+    for (GLuint location : {kSpriteRectLocation, kSpriteUvLocation, kSpriteLayerLocation, kSpriteTintLocation}) {
+        glVertexAttribBinding(location, kSpriteVertexBinding);
+        glEnableVertexAttribArray(location);
+    }
+    glVertexBindingDivisor(kSpriteVertexBinding, 1);
+    glBindVertexArray(GL_NONE);
+}
+
+void SpriteBatch::destroy()
+{
+    if (mVao) {
+        glDeleteVertexArrays(1, &mVao);
+        mStream.destroy();
+    }
+    mVao = GL_NONE;
+    mPrograms.clear();
+    mTextures.clear();
+    mCapacity = 0;
+    mCount = 0;
+    mMapped = nullptr;
+}
+
+std::uint16_t SpriteBatch::addProgram(GLuint program)
+{
+    mPrograms.push_back(program);
+    return static_cast<std::uint16_t>(mPrograms.size() - 1);
+}
+
+std::uint16_t SpriteBatch::addTexture(GLenum target, GLuint texture)
+{
+    mTextures.push_back({target, texture});
+    return static_cast<std::uint16_t>(mTextures.size() - 1);
+}
+
+void SpriteBatch::begin(FrameStats &stats)
+{
+    mCount = 0;
+    mSorted = true;
+    mMapped = static_cast<LogoInstance *>(mStream.acquire(stats));
+}
+
+void SpriteBatch::submit(std::uint16_t program, std::uint16_t texture, BlendMode blend, float depth)
+{
+    if (mCount == mCapacity)
+        return;
+
+    const auto quantizedDepth = static_cast<std::uint64_t>(std::max(0.0f, std::min(depth, 1.0f)) * 0xffffff);
+    mKeys[mCount] = (std::uint64_t {program} << kProgramShift) | (std::uint64_t {texture} << kTextureShift) | (static_cast<std::uint64_t>(blend) << kBlendShift) | (quantizedDepth << kDepthShift);
+    mOrder[mCount] = static_cast<std::uint32_t>(mCount);
+    mSorted = mSorted && (mCount == 0 || mKeys[mCount - 1] <= mKeys[mCount]);
+    mCount++;
+}
+
+void SpriteBatch::sort()
+{
+    if (mSorted)
+        return;
+
+    sortKeys();
+    // Turn "which submission goes here" into "where each submission goes".
+    for (std::size_t i = 0; i < mCount; i++)
+        mOrderScratch[mOrder[i]] = static_cast<std::uint32_t>(i);
+    mOrder.swap(mOrderScratch);
+}
+
+LogoInstance &SpriteBatch::instance(std::size_t submission)
+{
+    return mMapped[mSorted ? submission : mOrder[submission]];
+}
+
+void SpriteBatch::sortKeys()
+{
+    // LSD radix sort, 8 bits per pass, with all eight digit histograms
+    // gathered in one read of the keys. Passes where every key shares the
+    // same digit are skipped, which is most of them for a typical frame with
+    // a handful of programs and textures.
+    std::size_t histograms[8][256] = {};
+    for (std::size_t i = 0; i < mCount; i++) {
+        const std::uint64_t key = mKeys[i];
+        for (int digit = 0; digit < 8; digit++)
+            histograms[digit][(key >> (digit * 8)) & 0xff]++;
+    }
+
+    for (int digit = 0; digit < 8; digit++) {
+        std::size_t *histogram = histograms[digit];
+        const int shift = digit * 8;
+        if (histogram[(mKeys[0] >> shift) & 0xff] == mCount)
+            continue;
+
+        std::size_t offset = 0;
+        for (int bucket = 0; bucket < 256; bucket++) {
+            std::size_t n = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += n;
+        }
+
+        for (std::size_t i = 0; i < mCount; i++) {
+            std::size_t dst = histogram[(mKeys[i] >> shift) & 0xff]++;
+            mKeysScratch[dst] = mKeys[i];
+            mOrderScratch[dst] = mOrder[i];
+        }
+        mKeys.swap(mKeysScratch);
+        mOrder.swap(mOrderScratch);
+    }
+}
+
+static void applyBlend(GlState &state, BlendMode blend)
+{
+    switch (blend) {
+        case BlendMode::Alpha:
+            state.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            break;
+        case BlendMode::Additive:
+            state.blendFunc(GL_SRC_ALPHA, GL_ONE);
+            break;
+        case BlendMode::Premultiplied:
+            state.blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+            break;
+    }
+}
+
+void SpriteBatch::flush(GlState &state, FrameStats &stats)
+{
+    mStream.commit();
+    mMapped = nullptr;
+    if (mCount == 0) {
+        mStream.release();
+        return;
+    }
+
+    const GLuint regionBase = static_cast<GLuint>(mStream.regionIndex() * mCapacity);
+
+    state.bindVertexArray(mVao);
+    state.activeTexture(GL_TEXTURE0 + kLogoTextureUnit);
+    if (!mInstanceAttributes)
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kSpriteBufferBinding, mStream.buffer());
+
+    std::size_t runStart = 0;
+    while (runStart < mCount) {
+        const std::uint64_t runState = mKeys[runStart] & kStateMask;
+        std::size_t runEnd = runStart + 1;
+        while (runEnd < mCount && (mKeys[runEnd] & kStateMask) == runState)
+            runEnd++;
+
+        const Texture &texture = mTextures[(runState >> kTextureShift) & 0xffff];
+        state.useProgram(mPrograms[runState >> kProgramShift]);
+        if (texture.target != GL_NONE)
+            state.bindTexture(texture.target, texture.name);
+        applyBlend(state, static_cast<BlendMode>((runState >> kBlendShift) & 0xf));
+
+        // Every desktop program in the batch declares instanceBase at
+        // location 0; GLES has no base instance, so the binding moves instead.
+        if (mInstanceAttributes)
+            glBindVertexBuffer(kSpriteVertexBinding, mStream.buffer(), static_cast<GLintptr>((regionBase + runStart) * sizeof(LogoInstance)), sizeof(LogoInstance));
+        else
+            glUniform1ui(kInstanceBaseLocation, regionBase + static_cast<GLuint>(runStart));
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(runEnd - runStart));
+        stats.drawCalls++;
+
+        runStart = runEnd;
+    }
+
+    // Everything else expects premultiplied blending.
+    applyBlend(state, BlendMode::Premultiplied);
+    mStream.release();
+
+    stats.instances += mCount;
+}
+
+std::size_t SpriteBatch::capacity() const
+{
+    return mCapacity;
+}
@@ -0,0 +1,107 @@
+#ifndef SPRITE_BATCH_H
+#define SPRITE_BATCH_H
+
+#include "app_gl.h"
+#include "gl_state.h"
+#include "stats.h"
+#include "stream_buffer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Per-logo data pulled by instanced_vert.glsl; matches its std430 Instance.
+ * On GLES the same records feed instanced_es_vert.glsl's attributes.
+ */
+struct LogoInstance {
+    float x;
+    float y;
+    float width;
+    float height;
+    float u0;
+    float v0;
+    float u1;
+    float v1;
+    float layer;
+    std::uint32_t tint;    // RGBA8, red in the lowest byte; premultiplied for Premultiplied
+    /* Bindless texture handle, low word first; zero when unused. */
+    std::uint32_t handle[2];
+};
+static_assert(sizeof(LogoInstance) == 48, "LogoInstance must match the std430 Instance stride");
+
+enum class BlendMode : std::uint8_t {
+    Alpha,
+    Additive,
+    Premultiplied,
+};
+
+/*
+ * Collects sprites over a frame, sorts them by a 64-bit key
+ *
+ *   program:16 | texture:16 | blend:4 | depth:24 | unused:4
+ *
+ * and emits one instanced draw per run of equal program/texture/blend.
+ * Programs and textures are registered up front and referred to by index.
+ * All storage is sized in init(); a frame never allocates.
+ *
+ * A frame submits every sprite's key, sorts, then writes each sprite's
+ * instance through instance(), which points straight at its sorted slot in
+ * the stream buffer; only the keys and their order are ever moved, and a
+ * frame submitted in key order skips the sort and is written in place.
+ *
+ * Desktop GL pulls instances from a storage buffer and selects a run with
+ * an index offset. GLES 3.1 need not offer storage buffers to vertex
+ * shaders, so there the instances are per-instance attributes and each run
+ * rebinds the vertex buffer at its first instance.
+ */
+class SpriteBatch {
+public:
+    ~SpriteBatch();
+
+    void init(std::size_t capacity);
+    void destroy();
+
+    std::uint16_t addProgram(GLuint program);
+    /* GL_NONE as target registers "no binding", for bindless sprites. */
+    std::uint16_t addTexture(GLenum target, GLuint texture);
+
+    /* Claims this frame's region of the stream buffer, waiting if the GPU still reads it. */
+    void begin(FrameStats &stats);
+    /* depth is in [0, 1]; lower values are drawn first within a state run. */
+    void submit(std::uint16_t program, std::uint16_t texture, BlendMode blend, float depth);
+    /* Call after the last submit() and before any instance(). */
+    void sort();
+    /* Where the instance of the given submission, counting from 0 since begin(), is written. Write-only. */
+    LogoInstance &instance(std::size_t submission);
+    void flush(GlState &state, FrameStats &stats);
+
+    std::size_t capacity() const;
+
+private:
+    struct Texture {
+        GLenum target;
+        GLuint name;
+    };
+
+    void sortKeys();
+
+    GLuint mVao {GL_NONE};
+    bool mInstanceAttributes {false};
+    StreamBuffer mStream;
+    std::vector<GLuint> mPrograms;
+    std::vector<Texture> mTextures;
+
+    std::size_t mCapacity {0};
+    std::size_t mCount {0};
+    /* Whether keys arrived in order, so submission i is drawn i-th. */
+    bool mSorted {true};
+    LogoInstance *mMapped {nullptr};
+    std::vector<std::uint64_t> mKeys;
+    std::vector<std::uint64_t> mKeysScratch;
+    /* Submission index per sorted slot while sorting, then sorted slot per submission. */
+    std::vector<std::uint32_t> mOrder;
+    std::vector<std::uint32_t> mOrderScratch;
+};
+
+#endif    // SPRITE_BATCH_H
@@ -0,0 +1,110 @@
+#include "stats.h"
+
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#define HAVE_GETRUSAGE
+#endif
+
+void FrameStats::reset()
+{
+    *this = FrameStats {};
+}
+
+void StatsReporter::endFrame(const FrameStats &frame)
+{
+    mFrames++;
+    mTotals.drawCalls += frame.drawCalls;
+    mTotals.instances += frame.instances;
+    mTotals.fenceStalls += frame.fenceStalls;
+    mTotals.fenceStallMs += frame.fenceStallMs;
+    mTotals.stateCalls += frame.stateCalls;
+    mTotals.stateCallsElided += frame.stateCallsElided;
+    mTotals.submitMs += frame.submitMs;
+    mTotals.redrawnPixels += frame.redrawnPixels;
+    for (std::size_t pass = 0; pass < kRenderPassCount; pass++) {
+        mTotals.passCpuMs[pass] += frame.passCpuMs[pass];
+        mTotals.passGpuMs[pass] += frame.passGpuMs[pass];
+    }
+    mTotals.gpuFrames += frame.gpuFrames;
+    mTotals.resorts += frame.resorts;
+    mTotals.resortMs += frame.resortMs;
+    if (frame.resorts > 0)
+        mTotals.neighbourSpread = frame.neighbourSpread;
+
+    std::chrono::duration<double> elapsed = Clock::now() - mWindowStart;
+    if (elapsed.count() < 1.0)
+        return;
+
+    const double frames = static_cast<double>(mFrames);
+    std::cout << "frame: " << (elapsed.count() * 1000.0 / frames) << " ms"
+              << ", submit " << (mTotals.submitMs / frames) << " ms"
+              << ", draw calls " << (static_cast<double>(mTotals.drawCalls) / frames)
+              << ", instances " << (static_cast<double>(mTotals.instances) / frames)
+              << ", state calls " << (static_cast<double>(mTotals.stateCalls) / frames)
+              << " (+" << (static_cast<double>(mTotals.stateCallsElided) / frames) << " elided)"
+              << ", redrawn " << (static_cast<double>(mTotals.redrawnPixels) / frames) << " px"
+              << ", fence stalls " << mTotals.fenceStalls << " (" << mTotals.fenceStallMs << " ms)" << std::endl;
+
+    // Only the GL path times passes; GPU times appear once queries land.
+    double passCpuTotal = 0.0;
+    for (double ms : mTotals.passCpuMs)
+        passCpuTotal += ms;
+    if (passCpuTotal > 0.0) {
+        static constexpr const char *kPassNames[kRenderPassCount] {"clear", "trails", "logos"};
+        std::cout << "passes (cpu/gpu ms):";
+        for (std::size_t pass = 0; pass < kRenderPassCount; pass++) {
+            std::cout << (pass ? ", " : " ") << kPassNames[pass] << " " << (mTotals.passCpuMs[pass] / frames) << "/";
+            if (mTotals.gpuFrames > 0)
+                std::cout << (mTotals.passGpuMs[pass] / static_cast<double>(mTotals.gpuFrames));
+            else
+                std::cout << "-";
+        }
+        std::cout << std::endl;
+    }
+
+    if (mTotals.resorts > 0) {
+        std::cout << "resorts: " << mTotals.resorts << ", " << (mTotals.resortMs / static_cast<double>(mTotals.resorts)) << " ms each, neighbour spread "
+                  << mTotals.neighbourSpread << " px" << std::endl;
+    }
+
+    mWindowStart = Clock::now();
+    mFrames = 0;
+    mTotals = FrameStats {};
+}
+
+/* User plus system CPU seconds used by the process so far. */
+static double processCpuSeconds()
+{
+#ifdef HAVE_GETRUSAGE
+    rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    auto seconds = [](const timeval &time) { return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_usec) * 1e-6; };
+    return seconds(usage.ru_utime) + seconds(usage.ru_stime);
+#else
+    return 0.0;
+#endif
+}
+
+CpuUsageReporter::CpuUsageReporter()
+    : mCpuSecondsAtStart(processCpuSeconds())
+{
+}
+
+void CpuUsageReporter::poll()
+{
+#ifdef HAVE_GETRUSAGE
+    std::chrono::duration<double> elapsed = Clock::now() - mWindowStart;
+    if (elapsed.count() < 60.0)
+        return;
+
+    const double cpuSeconds = processCpuSeconds();
+    const double used = cpuSeconds - mCpuSecondsAtStart;
+    std::cout << "cpu: " << (used * 60.0 / elapsed.count()) << " s per minute ("
+              << (used * 100.0 / elapsed.count()) << "% of a core)" << std::endl;
+
+    mWindowStart = Clock::now();
+    mCpuSecondsAtStart = cpuSeconds;
+#endif
+}
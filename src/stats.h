@@ -0,0 +1,78 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+/* The passes App::render() times on the CPU and GPU; see PassTimer. */
+enum class RenderPass : std::size_t {
+    Clear,
+    Trails,
+    Logos,
+};
+
+constexpr std::size_t kRenderPassCount {3};
+
+/* Counters collected over one frame and the ticks before it; reset once reported. */
+struct FrameStats {
+    std::size_t drawCalls {0};
+    std::size_t instances {0};
+    /* Times the CPU had to wait for the GPU to free a stream buffer region. */
+    std::size_t fenceStalls {0};
+    double fenceStallMs {0.0};
+    /* State changes passed through to GL, and redundant ones skipped. */
+    std::size_t stateCalls {0};
+    std::size_t stateCallsElided {0};
+    /* CPU time spent building and submitting the logo draws. */
+    double submitMs {0.0};
+    /* Pixels cleared and redrawn, less than the window with damage tracking. */
+    std::size_t redrawnPixels {0};
+    /* CPU time issuing each pass this frame. */
+    std::array<double, kRenderPassCount> passCpuMs {};
+    /*
+     * GPU time per pass, summed over the gpuFrames earlier frames whose
+     * timer queries landed during this one.
+     */
+    std::array<double, kRenderPassCount> passGpuMs {};
+    std::size_t gpuFrames {0};
+    /* Morton re-sorts run by the ticks, their CPU time, and the neighbour spread the last one left. */
+    std::size_t resorts {0};
+    double resortMs {0.0};
+    double neighbourSpread {0.0};
+
+    void reset();
+};
+
+/* Averages FrameStats and prints them about once a second. */
+class StatsReporter {
+public:
+    void endFrame(const FrameStats &frame);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point mWindowStart {Clock::now()};
+    std::size_t mFrames {0};
+    FrameStats mTotals;
+};
+
+/*
+ * Prints the CPU time the process used over each minute, from getrusage(),
+ * so power modes can be compared. Does nothing where getrusage is missing.
+ */
+class CpuUsageReporter {
+public:
+    CpuUsageReporter();
+
+    /* Call regularly; prints once a minute has passed. */
+    void poll();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point mWindowStart {Clock::now()};
+    double mCpuSecondsAtStart {0.0};
+};
+
+#endif    // STATS_H
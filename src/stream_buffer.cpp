@@ -0,0 +1,117 @@
+#include "stream_buffer.h"
+
+#include "util.h"
+
+#include <chrono>
+#include <stdexcept>
+
+StreamBuffer::~StreamBuffer()
+{
+    destroy();
+}
+
+void StreamBuffer::init(std::size_t regionSize)
+{
+    destroy();
+
+    mRegionSize = regionSize;
+    const GLsizeiptr size = static_cast<GLsizeiptr>(regionSize * kRegions);
+    mRegion = kRegions - 1;
+
+    // Mapped a region at a time; GL_COPY_WRITE_BUFFER is a binding nothing
+    // else relies on.
+    mPersistent = !glIsEs();
+    if (!mPersistent) {
+        glGenBuffers(1, &mBuffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, mBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        return;
+    }
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glCreateBuffers(1, &mBuffer);
+    glNamedBufferStorage(mBuffer, size, nullptr, flags);
+    mMapped = static_cast<unsigned char *>(glMapNamedBufferRange(mBuffer, 0, size, flags));
+    if (!mMapped)
+        throw std::runtime_error("Failed to map stream buffer.");
+}
+
+void StreamBuffer::destroy()
+{
+    for (GLsync &fence : mFences) {
+        if (fence)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    if (mBuffer) {
+        if (mPersistent)
+            glUnmapNamedBuffer(mBuffer);
+        glDeleteBuffers(1, &mBuffer);
+    }
+    mBuffer = GL_NONE;
+    mMapped = nullptr;
+    mRegionSize = 0;
+}
+
+void *StreamBuffer::acquire(FrameStats &stats)
+{
+    mRegion = (mRegion + 1) % kRegions;
+
+    GLsync &fence = mFences[mRegion];
+    if (fence) {
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED) {
+            auto start = std::chrono::steady_clock::now();
+            while (result == GL_TIMEOUT_EXPIRED)
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            stats.fenceStalls++;
+            stats.fenceStallMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    if (!mPersistent) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, mBuffer);
+        void *region = glMapBufferRange(GL_COPY_WRITE_BUFFER, regionOffset(), static_cast<GLsizeiptr>(mRegionSize), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (!region)
+            throw std::runtime_error("Failed to map stream buffer.");
+        return region;
+    }
+
+    return mMapped + regionOffset();
+}
+
+void StreamBuffer::commit()
+{
+    if (!mPersistent) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, mBuffer);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    }
+}
+
+void StreamBuffer::release()
+{
+    mFences[mRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+GLuint StreamBuffer::buffer() const
+{
+    return mBuffer;
+}
+
+std::size_t StreamBuffer::regionSize() const
+{
+    return mRegionSize;
+}
+
+std::size_t StreamBuffer::regionIndex() const
+{
+    return static_cast<std::size_t>(mRegion);
+}
+
+GLintptr StreamBuffer::regionOffset() const
+{
+    return static_cast<GLintptr>(mRegionSize * static_cast<std::size_t>(mRegion));
+}
@@ -0,0 +1,49 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include "app_gl.h"
+#include "stats.h"
+
+#include <cstddef>
+
+/*
+ * Persistently mapped, coherent buffer split into per-frame regions. The CPU
+ * writes frame N into one region while the GPU may still be reading the
+ * previous ones; a fence per region makes acquire() wait only if the GPU has
+ * fallen a full ring behind.
+ *
+ * GLES has no persistent mapping without GL_EXT_buffer_storage, so there
+ * each region is mapped unsynchronized in acquire() and unmapped in
+ * commit(); the fences still keep the CPU off regions in flight.
+ */
+class StreamBuffer {
+public:
+    static constexpr int kRegions {3};
+
+    ~StreamBuffer();
+
+    void init(std::size_t regionSize);
+    void destroy();
+
+    /* Moves to the next region, waiting on its fence if the GPU still uses it. */
+    void *acquire(FrameStats &stats);
+    /* Call once the region is written, before drawing from it. */
+    void commit();
+    /* Call after the draws reading the current region have been issued. */
+    void release();
+
+    GLuint buffer() const;
+    std::size_t regionSize() const;
+    std::size_t regionIndex() const;
+    GLintptr regionOffset() const;
+
+private:
+    GLuint mBuffer {GL_NONE};
+    unsigned char *mMapped {nullptr};
+    bool mPersistent {true};
+    std::size_t mRegionSize {0};
+    int mRegion {kRegions - 1};
+    GLsync mFences[kRegions] {};
+};
+
+#endif    // STREAM_BUFFER_H
@@ -0,0 +1,69 @@
+#include "trails.h"
+
+void TrailBuffer::init(std::size_t logoCount, std::size_t length)
+{
+    mLogoCount = logoCount;
+    mLength = length;
+    mPositions.assign(logoCount * length * 2, 0.0f);
+    mHead = length ? length - 1 : 0;
+    mFilled = 0;
+}
+
+void TrailBuffer::push(const Logos &logos)
+{
+    if (mLength == 0)
+        return;
+
+    advance();
+
+    float *slot = &mPositions[mHead * mLogoCount * 2];
+    for (std::size_t i = 0; i < mLogoCount; i++) {
+        slot[i * 2 + 0] = logos.x[i];
+        slot[i * 2 + 1] = logos.y[i];
+    }
+}
+
+void TrailBuffer::advance()
+{
+    if (mLength == 0)
+        return;
+
+    mHead = (mHead + 1) % mLength;
+    if (mFilled < mLength)
+        mFilled++;
+}
+
+const float *TrailBuffer::data() const
+{
+    return mPositions.data();
+}
+
+float *TrailBuffer::mutableData()
+{
+    return mPositions.data();
+}
+
+std::size_t TrailBuffer::sizeBytes() const
+{
+    return mPositions.size() * sizeof(float);
+}
+
+std::size_t TrailBuffer::head() const
+{
+    return mHead;
+}
+
+std::size_t TrailBuffer::filled() const
+{
+    return mFilled;
+}
+
+std::size_t TrailBuffer::length() const
+{
+    return mLength;
+}
+
+std::size_t TrailBuffer::logoCount() const
+{
+    return mLogoCount;
+}
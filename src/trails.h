@@ -0,0 +1,42 @@
+#ifndef TRAILS_H
+#define TRAILS_H
+
+#include "logos.h"
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * Last `length` positions of every logo in one preallocated ring of
+ * {x, y} float pairs, costing logoCount * length * 8 bytes.
+ *
+ * Slots are laid out [slot][logo], so each push() writes one contiguous run
+ * of logoCount pairs that can be uploaded as a single range.
+ */
+class TrailBuffer {
+public:
+    void init(std::size_t logoCount, std::size_t length);
+    void push(const Logos &logos);
+    /* Moves head() on for a slot written on the GPU; data() keeps stale contents for it. */
+    void advance();
+
+    const float *data() const;
+    float *mutableData();
+    std::size_t sizeBytes() const;
+
+    /* Slot written by the most recent push(). */
+    std::size_t head() const;
+    /* Number of slots holding history, at most length(). */
+    std::size_t filled() const;
+    std::size_t length() const;
+    std::size_t logoCount() const;
+
+private:
+    std::vector<float> mPositions;
+    std::size_t mLogoCount {0};
+    std::size_t mLength {0};
+    std::size_t mHead {0};
+    std::size_t mFilled {0};
+};
+
+#endif    // TRAILS_H
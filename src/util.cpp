@@ -1,5 +1,9 @@
 #include "util.h"
 
+#include "mipmap.h"
+
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -7,6 +11,38 @@
 #include <streambuf>
 #include <vector>
 
+bool glIsEs()
+{
+    const auto *version = reinterpret_cast<const char *>(glGetString(GL_VERSION));
+    return version && std::strncmp(version, "OpenGL ES", 9) == 0;
+}
+
+bool glVersionAtLeast(int major, int minor)
+{
+    GLint contextMajor = 0;
+    GLint contextMinor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &contextMajor);
+    glGetIntegerv(GL_MINOR_VERSION, &contextMinor);
+    return contextMajor > major || (contextMajor == major && contextMinor >= minor);
+}
+
+bool glIsLegacy()
+{
+    return !glIsEs() && !glVersionAtLeast(4, 5);
+}
+
+bool glHasExtension(const char *name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const auto *extension = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+        if (extension && std::strcmp(extension, name) == 0)
+            return true;
+    }
+    return false;
+}
+
 std::string loadTextFile(const std::string &path)
 {
     std::ifstream file(path);
@@ -16,15 +52,34 @@ std::string loadTextFile(const std::string &path)
                        std::istreambuf_iterator<char>());
 }
 
-GLuint loadShader(const std::string &path, GLenum type)
+std::string loadShaderSource(const std::string &path, const std::string &defines)
 {
     auto src = loadTextFile(path);
-    const char *src_c = src.c_str();
+    if (!defines.empty()) {
+        std::size_t versionEnd = src.rfind("#version", 0) == 0 ? src.find('\n') + 1 : 0;
+        src.insert(versionEnd, defines);
+    }
+    return src;
+}
+
+GLuint loadShader(const std::string &path, GLenum type, const std::string &defines)
+{
+    return compileShader(loadShaderSource(path, defines), type, path);
+}
+
+GLuint compileShader(const std::string &source, GLenum type, const std::string &name)
+{
+    const char *src_c = source.c_str();
 
     GLuint shader = glCreateShader(type);
     glShaderSource(shader, 1, &src_c, NULL);
     glCompileShader(shader);
+    checkShader(shader, name);
+    return shader;
+}
 
+void checkShader(GLuint shader, const std::string &name)
+{
     GLint isCompiled = 0;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &isCompiled);
     if (isCompiled == GL_FALSE) {
@@ -35,19 +90,22 @@ GLuint loadShader(const std::string &path, GLenum type)
         glGetShaderInfoLog(shader, maxLength, &maxLength, &errorLog[0]);
 
         std::string error(errorLog.begin(), errorLog.end());
-        std::cerr << path + ":\n" + error << std::endl;
+        std::cerr << name + ":\n" + error << std::endl;
 
         glDeleteShader(shader);
 
         throw std::runtime_error("Problem with shader.");
     }
-
-    return shader;
 }
 
 void linkProgram(GLuint program)
 {
     glLinkProgram(program);
+    checkProgram(program);
+}
+
+void checkProgram(GLuint program)
+{
     GLint isLinked = 0;
     glGetProgramiv(program, GL_LINK_STATUS, &isLinked);
     if (isLinked == GL_FALSE) {
@@ -70,11 +128,13 @@ void linkProgram(GLuint program)
 #include <stb_image.h>
 
 struct StbImage {
-    StbImage(const std::string &path)
+    StbImage(const std::string &path, int desiredComponents = 0)
     {
         glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
         stbi_set_flip_vertically_on_load(false);
-        data = stbi_load(path.c_str(), &width, &height, &numComponents, 0);
+        data = stbi_load(path.c_str(), &width, &height, &numComponents, desiredComponents);
+        if (desiredComponents)
+            numComponents = desiredComponents;
         if (!data) {
             std::stringstream error;
             error << "Image (" << path << ") failed to load:\n";
@@ -93,40 +153,146 @@ struct StbImage {
     stbi_uc *data {nullptr};
 };
 
-GLenum componentsToFormat(int numComponents)
-{
-    switch (numComponents) {
-        case 1:
-            return GL_RED;
-        case 3:
-            return GL_RGB;
-        case 4:
-            return GL_RGBA;
-        default:
-            return GL_RGBA;
-    }
-    return GL_RGBA;
+GLuint loadTexture(const std::string &filePath, int &width, int &height, const std::string &mipCacheDir)
+{
+    Image image = loadImage(filePath);
+    width = image.width;
+    height = image.height;
+
+    // Premultiplied before filtering, so transparent texels' colour never
+    // bleeds into the smaller levels.
+    premultiplyAlpha(image);
+    return createMipmappedTexture(loadMipChain(image, mipCacheDir));
 }
 
-GLuint loadTexture(const std::string &filePath, int &width, int &height)
+Image loadImage(const std::string &filePath)
 {
-    StbImage image(filePath);
+    StbImage stbImage(filePath, 4);
 
-    GLenum format = componentsToFormat(image.numComponents);
+    Image image;
+    image.width = stbImage.width;
+    image.height = stbImage.height;
+    image.pixels.assign(stbImage.data, stbImage.data + static_cast<std::size_t>(image.width) * image.height * 4);
+    return image;
+}
+
+Image readFramebuffer(int width, int height)
+{
+    Image image;
+    image.width = width;
+    image.height = height;
+    image.pixels.resize(static_cast<std::size_t>(width) * height * 4);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.data());
+
+    // GL rows run bottom to top.
+    const std::size_t stride = static_cast<std::size_t>(width) * 4;
+    for (int y = 0; y < height / 2; y++)
+        std::swap_ranges(image.pixels.begin() + y * stride, image.pixels.begin() + (y + 1) * stride, image.pixels.begin() + (height - 1 - y) * stride);
+
+    return image;
+}
+
+void savePpm(const std::string &filePath, const Image &image)
+{
+    std::ofstream file(filePath, std::ios::binary);
+    file << "P6\n" << image.width << " " << image.height << "\n255\n";
+
+    std::vector<unsigned char> row(static_cast<std::size_t>(image.width) * 3);
+    for (int y = 0; y < image.height; y++) {
+        const unsigned char *src = image.pixels.data() + static_cast<std::size_t>(y) * image.width * 4;
+        for (int x = 0; x < image.width; x++) {
+            row[x * 3 + 0] = src[x * 4 + 0];
+            row[x * 3 + 1] = src[x * 4 + 1];
+            row[x * 3 + 2] = src[x * 4 + 2];
+        }
+        file.write(reinterpret_cast<const char *>(row.data()), static_cast<std::streamsize>(row.size()));
+    }
+
+    if (!file)
+        throw std::runtime_error("Failed to write image: " + filePath);
+}
+
+GLuint createMipmappedTexture(const std::vector<Image> &chain)
+{
+    const Image &base = chain.front();
+    const auto levels = static_cast<GLsizei>(chain.size());
 
     GLuint handle {GL_NONE};
-    glCreateTextures(GL_TEXTURE_2D, 1, &handle);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (glIsEs() || glIsLegacy()) {
+        glGenTextures(1, &handle);
+        glBindTexture(GL_TEXTURE_2D, handle);
+        if (glIsEs() || GLEW_ARB_texture_storage) {
+            glTexStorage2D(GL_TEXTURE_2D, levels, GL_RGBA8, base.width, base.height);
+            for (GLsizei level = 0; level < levels; level++)
+                glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, chain[level].width, chain[level].height, GL_RGBA, GL_UNSIGNED_BYTE, chain[level].pixels.data());
+        }
+        else {
+            // GL 3.3 without immutable storage: each level on its own.
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+            for (GLsizei level = 0; level < levels; level++)
+                glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, chain[level].width, chain[level].height, 0, GL_RGBA, GL_UNSIGNED_BYTE, chain[level].pixels.data());
+        }
 
-    glTextureStorage2D(handle, 1, GL_RGBA8, image.width, image.height);
-    glTextureSubImage2D(handle, 0, 0, 0, image.width, image.height, format, GL_UNSIGNED_BYTE, image.data);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        return handle;
+    }
 
-    glTextureParameteri(handle, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTextureParameteri(handle, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glCreateTextures(GL_TEXTURE_2D, 1, &handle);
+    glTextureStorage2D(handle, levels, GL_RGBA8, base.width, base.height);
+    for (GLsizei level = 0; level < levels; level++)
+        glTextureSubImage2D(handle, level, 0, 0, chain[level].width, chain[level].height, GL_RGBA, GL_UNSIGNED_BYTE, chain[level].pixels.data());
+
+    glTextureParameteri(handle, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(handle, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTextureParameteri(handle, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTextureParameteri(handle, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    width = image.width;
-    height = image.height;
+    return handle;
+}
+
+GLuint createTextureArray(const std::vector<Image> &images)
+{
+    const int width = images.front().width;
+    const int height = images.front().height;
+    const int levels = mipLevels(width, height);
+    for (const Image &image : images) {
+        if (image.width != width || image.height != height)
+            throw std::runtime_error("Texture array layers must all be the same size.");
+    }
+
+    GLuint handle {GL_NONE};
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (glIsEs()) {
+        glGenTextures(1, &handle);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, handle);
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, GL_RGBA8, width, height, static_cast<GLsizei>(images.size()));
+        for (std::size_t layer = 0; layer < images.size(); layer++)
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<GLint>(layer), width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, images[layer].pixels.data());
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        return handle;
+    }
+
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &handle);
+    glTextureStorage3D(handle, levels, GL_RGBA8, width, height, static_cast<GLsizei>(images.size()));
+    for (std::size_t layer = 0; layer < images.size(); layer++)
+        glTextureSubImage3D(handle, 0, 0, 0, static_cast<GLint>(layer), width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, images[layer].pixels.data());
+    glGenerateTextureMipmap(handle);
+
+    glTextureParameteri(handle, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(handle, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(handle, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTextureParameteri(handle, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
     return handle;
 }
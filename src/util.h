@@ -4,10 +4,55 @@
 #include "app_gl.h"
 
 #include <string>
+#include <vector>
+
+/* Decoded image, always expanded to tightly packed RGBA8. */
+struct Image {
+    int width {0};
+    int height {0};
+    std::vector<unsigned char> pixels;
+};
+
+/* True when the current context is OpenGL ES rather than desktop GL. */
+bool glIsEs();
+/* Whether the context's GL or GLES version is at least major.minor. With
+ * glewExperimental, GLEW's version flags only say the entry points loaded. */
+bool glVersionAtLeast(int major, int minor);
+/* True for desktop GL older than 4.5, e.g. the 3.3 core fallback: no DSA,
+ * no storage buffers and no #version 450 shaders. */
+bool glIsLegacy();
+/* Whether the current context lists the extension, e.g. "GL_EXT_disjoint_timer_query". */
+bool glHasExtension(const char *name);
 
 std::string loadTextFile(const std::string &path);
-GLuint loadShader(const std::string &path, GLenum type);
+/* `defines` (e.g. "#define FOO\n") is inserted right after the #version line. */
+std::string loadShaderSource(const std::string &path, const std::string &defines = "");
+GLuint loadShader(const std::string &path, GLenum type, const std::string &defines = "");
+/* name only labels the compile log. */
+GLuint compileShader(const std::string &source, GLenum type, const std::string &name);
 void linkProgram(GLuint program);
-GLuint loadTexture(const std::string &filePath, int &width, int &height);
+/*
+ * Throw, after printing the log and deleting the object, if compiling or
+ * linking failed; for compiles and links issued without waiting on them.
+ */
+void checkShader(GLuint shader, const std::string &name);
+void checkProgram(GLuint program);
+/*
+ * Premultiplied alpha, full mip chain built on the CPU or read from
+ * mipCacheDir (see loadMipChain()).
+ */
+GLuint loadTexture(const std::string &filePath, int &width, int &height, const std::string &mipCacheDir = "");
+Image loadImage(const std::string &filePath);
+/* Reads the bound read framebuffer's colour into a top-down image. */
+Image readFramebuffer(int width, int height);
+/* Binary PPM (P6); alpha is dropped. */
+void savePpm(const std::string &filePath, const Image &image);
+/*
+ * Allocates a GL_TEXTURE_2D for a whole mip chain, uploads every level and sets trilinear filtering.
+ * On GLES this and createTextureArray() bind the texture on the active unit.
+ */
+GLuint createMipmappedTexture(const std::vector<Image> &chain);
+/* All images must share one size; layer i holds images[i]. */
+GLuint createTextureArray(const std::vector<Image> &images);
 
 #endif    // UTIL_H
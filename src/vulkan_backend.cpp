@@ -0,0 +1,1224 @@
+#include "vulkan_backend.h"
+
+#include <stdexcept>
+
+#ifdef DVD_VULKAN
+
+#include "atlas.h"
+#include "mipmap.h"
+#include "worker_pool.h"
+
+#include <vulkan/vulkan.h>
+
+#ifdef __linux__
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_vulkan.h>
+#else
+#include <SDL.h>
+#include <SDL_vulkan.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+
+// Below this many logos, waking the pool to write instances costs more
+// than it saves.
+static constexpr std::size_t kMinInstancesPerWrite {4096};
+
+/* Per-instance vertex attributes of vk_sprite_vert.glsl. */
+struct SpriteInstance {
+    float x;    // centre, in pixels
+    float y;
+    float width;
+    float height;
+    float u0;
+    float v0;
+    float u1;
+    float v1;
+    float layer;
+    std::uint32_t tint;    // RGBA8, red in the lowest byte
+};
+static_assert(sizeof(SpriteInstance) == 40, "SpriteInstance must match the vertex attribute layout");
+
+/* Size and atlas placement of one logo image. */
+struct Variant {
+    float width;
+    float height;
+    float layer;
+    float u0;
+    float v0;
+    float u1;
+    float v1;
+};
+
+struct Buffer {
+    VkBuffer buffer {VK_NULL_HANDLE};
+    VkDeviceMemory memory {VK_NULL_HANDLE};
+    void *mapped {nullptr};
+};
+
+/* Everything one frame in flight writes or records. */
+struct Frame {
+    /* Per-chunk VkDrawIndirectCommands, then the instances. */
+    Buffer buffer;
+    VkCommandPool pool {VK_NULL_HANDLE};
+    VkCommandBuffer primary {VK_NULL_HANDLE};
+    VkFence fence {VK_NULL_HANDLE};
+    VkSemaphore imageAvailable {VK_NULL_HANDLE};
+    /* One per chunk, recorded once and run by every primary of this slot. */
+    std::vector<VkCommandBuffer> secondaries;
+};
+
+/* A swapchain image, or the one offscreen image. */
+struct Target {
+    VkImage image {VK_NULL_HANDLE};
+    VkImageView view {VK_NULL_HANDLE};
+    VkFramebuffer framebuffer {VK_NULL_HANDLE};
+    VkSemaphore renderFinished {VK_NULL_HANDLE};
+};
+
+static void check(VkResult result, const char *call)
+{
+    if (result != VK_SUCCESS)
+        throw std::runtime_error(std::string(call) + " failed: VkResult " + std::to_string(static_cast<int>(result)));
+}
+
+static constexpr const char *kValidationLayer {"VK_LAYER_KHRONOS_validation"};
+
+/* Messenger callback; user is the Device's error count. */
+static VKAPI_ATTR VkBool32 VKAPI_CALL reportValidation(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT,
+                                                       const VkDebugUtilsMessengerCallbackDataEXT *data, void *user)
+{
+    if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
+        (*static_cast<std::atomic<std::size_t> *>(user))++;
+    std::cerr << "Vulkan validation: " << data->pMessage << std::endl;
+    return VK_FALSE;
+}
+
+static std::vector<std::uint32_t> loadSpirv(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("Failed to open " + path);
+
+    std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (bytes.empty() || bytes.size() % 4 != 0)
+        throw std::runtime_error(path + " is not SPIR-V");
+
+    std::vector<std::uint32_t> words(bytes.size() / 4);
+    std::memcpy(words.data(), bytes.data(), bytes.size());
+    return words;
+}
+
+struct VulkanBackend::Device {
+    ~Device();
+
+    void createInstance(SDL_Window *window, bool validate);
+    void pickPhysicalDevice();
+    void createDevice();
+    void createRenderPass();
+    void createPipeline();
+    /* False while the window has no area, e.g. minimized. */
+    bool createSwapchain();
+    void destroyTargets();
+    void createOffscreen();
+    void createFrames();
+    void recordSecondaries();
+    void writeInstances(Frame &frame, const Logos &logos);
+
+    std::uint32_t memoryType(std::uint32_t typeBits, VkMemoryPropertyFlags flags) const;
+    Buffer createBuffer(VkDeviceSize size, VkBufferUsageFlags usage);
+    void destroyBuffer(Buffer &buffer);
+    VkImageView createView(VkImage image, VkFormat format, VkImageViewType type, std::uint32_t levels, std::uint32_t layers);
+    VkCommandBuffer beginOneShot();
+    void endOneShot(VkCommandBuffer commands);
+
+    SDL_Window *window {nullptr};
+    int width {0};
+    int height {0};
+    std::size_t capacity {0};
+    unsigned threads {1};
+    std::uint32_t clearColour {0};
+    float scale {1.0f};
+    WorkerPool pool;
+    std::vector<Variant> variants;
+
+    VkInstance instance {VK_NULL_HANDLE};
+    VkDebugUtilsMessengerEXT messenger {VK_NULL_HANDLE};
+    std::atomic<std::size_t> validationErrors {0};
+    VkSurfaceKHR surface {VK_NULL_HANDLE};
+    VkPhysicalDevice physicalDevice {VK_NULL_HANDLE};
+    VkPhysicalDeviceMemoryProperties memoryProperties {};
+    VkPhysicalDeviceLimits limits {};
+    std::uint32_t queueFamily {0};
+    VkDevice device {VK_NULL_HANDLE};
+    VkQueue queue {VK_NULL_HANDLE};
+
+    VkFormat format {VK_FORMAT_R8G8B8A8_UNORM};
+    VkColorSpaceKHR colourSpace {VK_COLOR_SPACE_SRGB_NONLINEAR_KHR};
+    VkExtent2D extent {0, 0};
+    VkSwapchainKHR swapchain {VK_NULL_HANDLE};
+    std::vector<Target> targets;
+    VkDeviceMemory offscreenMemory {VK_NULL_HANDLE};
+
+    VkRenderPass renderPass {VK_NULL_HANDLE};
+    VkDescriptorSetLayout setLayout {VK_NULL_HANDLE};
+    VkPipelineLayout pipelineLayout {VK_NULL_HANDLE};
+    VkPipeline pipeline {VK_NULL_HANDLE};
+    VkDescriptorPool descriptorPool {VK_NULL_HANDLE};
+    VkDescriptorSet descriptorSet {VK_NULL_HANDLE};
+    VkSampler sampler {VK_NULL_HANDLE};
+
+    VkImage atlas {VK_NULL_HANDLE};
+    VkDeviceMemory atlasMemory {VK_NULL_HANDLE};
+    VkImageView atlasView {VK_NULL_HANDLE};
+
+    std::size_t chunks {1};
+    std::size_t chunkSize {0};
+    VkDeviceSize instanceOffset {0};
+    Frame frames[kFramesInFlight];
+    std::size_t frameIndex {0};
+    /* One pool per recording thread; pools are not thread safe. */
+    std::vector<VkCommandPool> recordPools;
+    VkCommandPool oneShotPool {VK_NULL_HANDLE};
+};
+
+VulkanBackend::Device::~Device()
+{
+    if (device) {
+        vkDeviceWaitIdle(device);
+
+        for (Frame &frame : frames) {
+            destroyBuffer(frame.buffer);
+            vkDestroyCommandPool(device, frame.pool, nullptr);
+            vkDestroyFence(device, frame.fence, nullptr);
+            vkDestroySemaphore(device, frame.imageAvailable, nullptr);
+        }
+        for (VkCommandPool pool : recordPools)
+            vkDestroyCommandPool(device, pool, nullptr);
+        vkDestroyCommandPool(device, oneShotPool, nullptr);
+
+        vkDestroyImageView(device, atlasView, nullptr);
+        vkDestroyImage(device, atlas, nullptr);
+        vkFreeMemory(device, atlasMemory, nullptr);
+        vkDestroySampler(device, sampler, nullptr);
+        vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+        vkDestroyPipeline(device, pipeline, nullptr);
+        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+        vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+
+        // Offscreen, the swapchain and surface extensions are not enabled,
+        // so their entry points must not be called even with null handles.
+        destroyTargets();
+        if (swapchain)
+            vkDestroySwapchainKHR(device, swapchain, nullptr);
+        vkDestroyRenderPass(device, renderPass, nullptr);
+        vkDestroyDevice(device, nullptr);
+    }
+
+    if (instance) {
+        if (surface)
+            vkDestroySurfaceKHR(instance, surface, nullptr);
+        if (messenger) {
+            auto destroyMessenger =
+                reinterpret_cast<PFN_vkDestroyDebugUtilsMessengerEXT>(vkGetInstanceProcAddr(instance, "vkDestroyDebugUtilsMessengerEXT"));
+            destroyMessenger(instance, messenger, nullptr);
+        }
+        vkDestroyInstance(instance, nullptr);
+    }
+}
+
+void VulkanBackend::Device::createInstance(SDL_Window *sdlWindow, bool validate)
+{
+    window = sdlWindow;
+
+    std::vector<const char *> extensions;
+    if (window) {
+        unsigned int count = 0;
+        if (!SDL_Vulkan_GetInstanceExtensions(window, &count, nullptr))
+            throw std::runtime_error(std::string("SDL_Vulkan_GetInstanceExtensions failed: ") + SDL_GetError());
+        extensions.resize(count);
+        SDL_Vulkan_GetInstanceExtensions(window, &count, extensions.data());
+    }
+
+    // The layer provides VK_EXT_debug_utils itself. Chained into the create
+    // info, the messenger also covers vkCreateInstance and vkDestroyInstance.
+    std::vector<const char *> layers;
+    VkDebugUtilsMessengerCreateInfoEXT messengerInfo {VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT};
+    if (validate) {
+        std::uint32_t count = 0;
+        vkEnumerateInstanceLayerProperties(&count, nullptr);
+        std::vector<VkLayerProperties> available(count);
+        vkEnumerateInstanceLayerProperties(&count, available.data());
+        const bool found = std::any_of(available.begin(), available.end(),
+                                       [](const VkLayerProperties &layer) { return std::strcmp(layer.layerName, kValidationLayer) == 0; });
+        if (!found)
+            throw std::runtime_error(std::string(kValidationLayer) + " is not installed");
+
+        layers.push_back(kValidationLayer);
+        extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+        messengerInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+        messengerInfo.messageType =
+            VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+        messengerInfo.pfnUserCallback = reportValidation;
+        messengerInfo.pUserData = &validationErrors;
+    }
+
+    VkApplicationInfo app {VK_STRUCTURE_TYPE_APPLICATION_INFO};
+    app.pApplicationName = "DVD";
+    app.apiVersion = VK_API_VERSION_1_0;
+
+    VkInstanceCreateInfo info {VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO};
+    info.pNext = validate ? &messengerInfo : nullptr;
+    info.pApplicationInfo = &app;
+    info.enabledLayerCount = static_cast<std::uint32_t>(layers.size());
+    info.ppEnabledLayerNames = layers.data();
+    info.enabledExtensionCount = static_cast<std::uint32_t>(extensions.size());
+    info.ppEnabledExtensionNames = extensions.data();
+    check(vkCreateInstance(&info, nullptr, &instance), "vkCreateInstance");
+
+    if (validate) {
+        auto createMessenger = reinterpret_cast<PFN_vkCreateDebugUtilsMessengerEXT>(vkGetInstanceProcAddr(instance, "vkCreateDebugUtilsMessengerEXT"));
+        check(createMessenger(instance, &messengerInfo, nullptr, &messenger), "vkCreateDebugUtilsMessengerEXT");
+    }
+
+    if (window && !SDL_Vulkan_CreateSurface(window, instance, &surface))
+        throw std::runtime_error(std::string("SDL_Vulkan_CreateSurface failed: ") + SDL_GetError());
+}
+
+void VulkanBackend::Device::pickPhysicalDevice()
+{
+    std::uint32_t count = 0;
+    vkEnumeratePhysicalDevices(instance, &count, nullptr);
+    std::vector<VkPhysicalDevice> devices(count);
+    vkEnumeratePhysicalDevices(instance, &count, devices.data());
+
+    // Any GPU beats a CPU implementation such as lavapipe, which is still
+    // taken when it is all there is.
+    auto rank = [](VkPhysicalDeviceType type) {
+        switch (type) {
+            case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+                return 3;
+            case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+                return 2;
+            case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+                return 1;
+            default:
+                return 0;
+        }
+    };
+
+    int bestRank = -1;
+    for (VkPhysicalDevice candidate : devices) {
+        std::uint32_t familyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(candidate, &familyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> families(familyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(candidate, &familyCount, families.data());
+
+        for (std::uint32_t family = 0; family < familyCount; family++) {
+            VkBool32 present = VK_TRUE;
+            if (surface)
+                vkGetPhysicalDeviceSurfaceSupportKHR(candidate, family, surface, &present);
+            if (!(families[family].queueFlags & VK_QUEUE_GRAPHICS_BIT) || !present)
+                continue;
+
+            VkPhysicalDeviceProperties properties;
+            vkGetPhysicalDeviceProperties(candidate, &properties);
+            if (rank(properties.deviceType) > bestRank) {
+                bestRank = rank(properties.deviceType);
+                physicalDevice = candidate;
+                queueFamily = family;
+                limits = properties.limits;
+            }
+            break;
+        }
+    }
+
+    if (!physicalDevice)
+        throw std::runtime_error("No Vulkan device can draw to this window");
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+}
+
+void VulkanBackend::Device::createDevice()
+{
+    const float priority = 1.0f;
+    VkDeviceQueueCreateInfo queueInfo {VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO};
+    queueInfo.queueFamilyIndex = queueFamily;
+    queueInfo.queueCount = 1;
+    queueInfo.pQueuePriorities = &priority;
+
+    const char *swapchainExtension = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+    VkDeviceCreateInfo info {VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
+    info.queueCreateInfoCount = 1;
+    info.pQueueCreateInfos = &queueInfo;
+    info.enabledExtensionCount = surface ? 1 : 0;
+    info.ppEnabledExtensionNames = &swapchainExtension;
+    check(vkCreateDevice(physicalDevice, &info, nullptr, &device), "vkCreateDevice");
+    vkGetDeviceQueue(device, queueFamily, 0, &queue);
+
+    VkCommandPoolCreateInfo poolInfo {VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = queueFamily;
+    check(vkCreateCommandPool(device, &poolInfo, nullptr, &oneShotPool), "vkCreateCommandPool");
+
+    if (!surface)
+        return;
+
+    // Plain UNORM, as the GL default framebuffer is; any order of channels.
+    std::uint32_t count = 0;
+    vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &count, nullptr);
+    std::vector<VkSurfaceFormatKHR> formats(count);
+    vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &count, formats.data());
+    if (formats.empty())
+        throw std::runtime_error("Vulkan surface has no formats");
+
+    format = formats.front().format;
+    colourSpace = formats.front().colorSpace;
+    for (const VkSurfaceFormatKHR &candidate : formats) {
+        if (candidate.format == VK_FORMAT_B8G8R8A8_UNORM || candidate.format == VK_FORMAT_R8G8B8A8_UNORM) {
+            format = candidate.format;
+            colourSpace = candidate.colorSpace;
+            break;
+        }
+    }
+}
+
+void VulkanBackend::Device::createRenderPass()
+{
+    VkAttachmentDescription colour {};
+    colour.format = format;
+    colour.samples = VK_SAMPLE_COUNT_1_BIT;
+    colour.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    colour.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    colour.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    colour.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    colour.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    colour.finalLayout = surface ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR : VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+    VkAttachmentReference reference {0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+    VkSubpassDescription subpass {};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &reference;
+
+    // Wait for the acquire. Every frame in flight draws to the one offscreen
+    // image, so there the clear must also wait for the previous frame's
+    // colour writes and for any capture() copy reading it.
+    VkSubpassDependency dependencies[2] {};
+    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[0].dstSubpass = 0;
+    dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    if (!surface) {
+        dependencies[0].srcStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dependencies[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    }
+    dependencies[1].srcSubpass = 0;
+    dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    VkRenderPassCreateInfo info {VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO};
+    info.attachmentCount = 1;
+    info.pAttachments = &colour;
+    info.subpassCount = 1;
+    info.pSubpasses = &subpass;
+    info.dependencyCount = surface ? 1 : 2;
+    info.pDependencies = dependencies;
+    check(vkCreateRenderPass(device, &info, nullptr, &renderPass), "vkCreateRenderPass");
+}
+
+void VulkanBackend::Device::createPipeline()
+{
+    VkDescriptorSetLayoutBinding binding {};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    VkDescriptorSetLayoutCreateInfo setInfo {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+    setInfo.bindingCount = 1;
+    setInfo.pBindings = &binding;
+    check(vkCreateDescriptorSetLayout(device, &setInfo, nullptr, &setLayout), "vkCreateDescriptorSetLayout");
+
+    // The pixel size of the arena, which the viewport then fills.
+    VkPushConstantRange pushRange {VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(float) * 2};
+    VkPipelineLayoutCreateInfo layoutInfo {VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &setLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushRange;
+    check(vkCreatePipelineLayout(device, &layoutInfo, nullptr, &pipelineLayout), "vkCreatePipelineLayout");
+
+    VkShaderModule modules[2] {};
+    const char *paths[2] = {"vk_sprite_vert.spv", "vk_sprite_frag.spv"};
+    for (int i = 0; i < 2; i++) {
+        const std::vector<std::uint32_t> code = loadSpirv(paths[i]);
+        VkShaderModuleCreateInfo moduleInfo {VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
+        moduleInfo.codeSize = code.size() * sizeof(std::uint32_t);
+        moduleInfo.pCode = code.data();
+        check(vkCreateShaderModule(device, &moduleInfo, nullptr, &modules[i]), "vkCreateShaderModule");
+    }
+
+    VkPipelineShaderStageCreateInfo stages[2] {};
+    stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module = modules[0];
+    stages[0].pName = "main";
+    stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].module = modules[1];
+    stages[1].pName = "main";
+
+    VkVertexInputBindingDescription instanceBinding {0, sizeof(SpriteInstance), VK_VERTEX_INPUT_RATE_INSTANCE};
+    VkVertexInputAttributeDescription attributes[4] = {
+        {0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(SpriteInstance, x)},
+        {1, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(SpriteInstance, u0)},
+        {2, 0, VK_FORMAT_R32_SFLOAT, offsetof(SpriteInstance, layer)},
+        {3, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(SpriteInstance, tint)},
+    };
+    VkPipelineVertexInputStateCreateInfo vertexInput {VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
+    vertexInput.vertexBindingDescriptionCount = 1;
+    vertexInput.pVertexBindingDescriptions = &instanceBinding;
+    vertexInput.vertexAttributeDescriptionCount = 4;
+    vertexInput.pVertexAttributeDescriptions = attributes;
+
+    VkPipelineInputAssemblyStateCreateInfo assembly {VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO};
+    assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+
+    // Viewport and scissor follow the swapchain, so they are set in the
+    // secondaries rather than baked in here.
+    VkPipelineViewportStateCreateInfo viewport {VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO};
+    viewport.viewportCount = 1;
+    viewport.scissorCount = 1;
+    VkDynamicState dynamicStates[2] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    VkPipelineDynamicStateCreateInfo dynamic {VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO};
+    dynamic.dynamicStateCount = 2;
+    dynamic.pDynamicStates = dynamicStates;
+
+    VkPipelineRasterizationStateCreateInfo raster {VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO};
+    raster.polygonMode = VK_POLYGON_MODE_FILL;
+    raster.cullMode = VK_CULL_MODE_NONE;
+    raster.lineWidth = 1.0f;
+
+    VkPipelineMultisampleStateCreateInfo multisample {VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO};
+    multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    // The same premultiplied blending as the GL path.
+    VkPipelineColorBlendAttachmentState blend {};
+    blend.blendEnable = VK_TRUE;
+    blend.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+    blend.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    blend.colorBlendOp = VK_BLEND_OP_ADD;
+    blend.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    blend.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    blend.alphaBlendOp = VK_BLEND_OP_ADD;
+    blend.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    VkPipelineColorBlendStateCreateInfo blendState {VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO};
+    blendState.attachmentCount = 1;
+    blendState.pAttachments = &blend;
+
+    VkGraphicsPipelineCreateInfo info {VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
+    info.stageCount = 2;
+    info.pStages = stages;
+    info.pVertexInputState = &vertexInput;
+    info.pInputAssemblyState = &assembly;
+    info.pViewportState = &viewport;
+    info.pRasterizationState = &raster;
+    info.pMultisampleState = &multisample;
+    info.pColorBlendState = &blendState;
+    info.pDynamicState = &dynamic;
+    info.layout = pipelineLayout;
+    info.renderPass = renderPass;
+    info.subpass = 0;
+    const VkResult result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &info, nullptr, &pipeline);
+
+    vkDestroyShaderModule(device, modules[0], nullptr);
+    vkDestroyShaderModule(device, modules[1], nullptr);
+    check(result, "vkCreateGraphicsPipelines");
+
+    VkSamplerCreateInfo samplerInfo {VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+    check(vkCreateSampler(device, &samplerInfo, nullptr, &sampler), "vkCreateSampler");
+
+    VkDescriptorPoolSize poolSize {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1};
+    VkDescriptorPoolCreateInfo poolInfo {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    check(vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool), "vkCreateDescriptorPool");
+
+    VkDescriptorSetAllocateInfo allocInfo {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &setLayout;
+    check(vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet), "vkAllocateDescriptorSets");
+}
+
+bool VulkanBackend::Device::createSwapchain()
+{
+    VkSurfaceCapabilitiesKHR caps;
+    check(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &caps), "vkGetPhysicalDeviceSurfaceCapabilitiesKHR");
+
+    VkExtent2D size = caps.currentExtent;
+    if (size.width == UINT32_MAX) {
+        size.width = std::min(std::max(static_cast<std::uint32_t>(width), caps.minImageExtent.width), caps.maxImageExtent.width);
+        size.height = std::min(std::max(static_cast<std::uint32_t>(height), caps.minImageExtent.height), caps.maxImageExtent.height);
+    }
+    if (size.width == 0 || size.height == 0)
+        return false;
+
+    std::uint32_t imageCount = caps.minImageCount + 1;
+    if (caps.maxImageCount != 0)
+        imageCount = std::min(imageCount, caps.maxImageCount);
+
+    // Opaque where the surface allows it, else the first mode it lists.
+    VkCompositeAlphaFlagBitsKHR compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    if (!(caps.supportedCompositeAlpha & compositeAlpha)) {
+        for (std::uint32_t bit = 1; bit != 0; bit <<= 1) {
+            if (caps.supportedCompositeAlpha & bit) {
+                compositeAlpha = static_cast<VkCompositeAlphaFlagBitsKHR>(bit);
+                break;
+            }
+        }
+    }
+
+    // FIFO is the only mode every driver has, and matches the GL path's vsync.
+    VkSwapchainCreateInfoKHR info {VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR};
+    info.surface = surface;
+    info.minImageCount = imageCount;
+    info.imageFormat = format;
+    info.imageColorSpace = colourSpace;
+    info.imageExtent = size;
+    info.imageArrayLayers = 1;
+    info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    info.preTransform = caps.currentTransform;
+    info.compositeAlpha = compositeAlpha;
+    info.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    info.clipped = VK_TRUE;
+    info.oldSwapchain = swapchain;
+
+    VkSwapchainKHR created = VK_NULL_HANDLE;
+    check(vkCreateSwapchainKHR(device, &info, nullptr, &created), "vkCreateSwapchainKHR");
+    destroyTargets();
+    vkDestroySwapchainKHR(device, swapchain, nullptr);
+    swapchain = created;
+    extent = size;
+
+    std::uint32_t count = 0;
+    vkGetSwapchainImagesKHR(device, swapchain, &count, nullptr);
+    std::vector<VkImage> images(count);
+    vkGetSwapchainImagesKHR(device, swapchain, &count, images.data());
+
+    for (VkImage image : images) {
+        Target target;
+        target.image = image;
+        target.view = createView(image, format, VK_IMAGE_VIEW_TYPE_2D, 1, 1);
+
+        VkFramebufferCreateInfo framebufferInfo {VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO};
+        framebufferInfo.renderPass = renderPass;
+        framebufferInfo.attachmentCount = 1;
+        framebufferInfo.pAttachments = &target.view;
+        framebufferInfo.width = extent.width;
+        framebufferInfo.height = extent.height;
+        framebufferInfo.layers = 1;
+        check(vkCreateFramebuffer(device, &framebufferInfo, nullptr, &target.framebuffer), "vkCreateFramebuffer");
+
+        VkSemaphoreCreateInfo semaphoreInfo {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+        check(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &target.renderFinished), "vkCreateSemaphore");
+        targets.push_back(target);
+    }
+
+    return true;
+}
+
+void VulkanBackend::Device::destroyTargets()
+{
+    for (Target &target : targets) {
+        vkDestroySemaphore(device, target.renderFinished, nullptr);
+        vkDestroyFramebuffer(device, target.framebuffer, nullptr);
+        vkDestroyImageView(device, target.view, nullptr);
+        // Swapchain images belong to the swapchain.
+        if (!swapchain)
+            vkDestroyImage(device, target.image, nullptr);
+    }
+    targets.clear();
+
+    vkFreeMemory(device, offscreenMemory, nullptr);
+    offscreenMemory = VK_NULL_HANDLE;
+}
+
+void VulkanBackend::Device::createOffscreen()
+{
+    extent = {static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height)};
+
+    Target target;
+    VkImageCreateInfo imageInfo {VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = format;
+    imageInfo.extent = {extent.width, extent.height, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    check(vkCreateImage(device, &imageInfo, nullptr, &target.image), "vkCreateImage");
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(device, target.image, &requirements);
+    VkMemoryAllocateInfo allocInfo {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    allocInfo.allocationSize = requirements.size;
+    allocInfo.memoryTypeIndex = memoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    check(vkAllocateMemory(device, &allocInfo, nullptr, &offscreenMemory), "vkAllocateMemory");
+    check(vkBindImageMemory(device, target.image, offscreenMemory, 0), "vkBindImageMemory");
+
+    target.view = createView(target.image, format, VK_IMAGE_VIEW_TYPE_2D, 1, 1);
+
+    VkFramebufferCreateInfo framebufferInfo {VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO};
+    framebufferInfo.renderPass = renderPass;
+    framebufferInfo.attachmentCount = 1;
+    framebufferInfo.pAttachments = &target.view;
+    framebufferInfo.width = extent.width;
+    framebufferInfo.height = extent.height;
+    framebufferInfo.layers = 1;
+    check(vkCreateFramebuffer(device, &framebufferInfo, nullptr, &target.framebuffer), "vkCreateFramebuffer");
+    targets.push_back(target);
+}
+
+void VulkanBackend::Device::createFrames()
+{
+    // Each recording thread gets one chunk; indirect draws let a chunk's
+    // instance count change every frame without re-recording.
+    chunks = std::max<std::size_t>(1, std::min<std::size_t>(threads, capacity));
+    chunkSize = (capacity + chunks - 1) / chunks;
+    instanceOffset = (chunks * sizeof(VkDrawIndirectCommand) + 63) / 64 * 64;
+
+    for (Frame &frame : frames) {
+        frame.buffer = createBuffer(instanceOffset + capacity * sizeof(SpriteInstance), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+
+        auto *commands = static_cast<VkDrawIndirectCommand *>(frame.buffer.mapped);
+        for (std::size_t chunk = 0; chunk < chunks; chunk++)
+            commands[chunk] = {4, 0, 0, 0};
+
+        VkCommandPoolCreateInfo poolInfo {VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        poolInfo.queueFamilyIndex = queueFamily;
+        check(vkCreateCommandPool(device, &poolInfo, nullptr, &frame.pool), "vkCreateCommandPool");
+
+        VkCommandBufferAllocateInfo allocInfo {VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+        allocInfo.commandPool = frame.pool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+        check(vkAllocateCommandBuffers(device, &allocInfo, &frame.primary), "vkAllocateCommandBuffers");
+
+        VkFenceCreateInfo fenceInfo {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+        check(vkCreateFence(device, &fenceInfo, nullptr, &frame.fence), "vkCreateFence");
+        VkSemaphoreCreateInfo semaphoreInfo {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+        check(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &frame.imageAvailable), "vkCreateSemaphore");
+    }
+
+    for (std::size_t chunk = 0; chunk < chunks; chunk++) {
+        VkCommandPoolCreateInfo poolInfo {VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+        poolInfo.queueFamilyIndex = queueFamily;
+        VkCommandPool pool = VK_NULL_HANDLE;
+        check(vkCreateCommandPool(device, &poolInfo, nullptr, &pool), "vkCreateCommandPool");
+        recordPools.push_back(pool);
+
+        VkCommandBufferAllocateInfo allocInfo {VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+        allocInfo.commandPool = pool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = 1;
+        for (Frame &frame : frames) {
+            VkCommandBuffer secondary = VK_NULL_HANDLE;
+            check(vkAllocateCommandBuffers(device, &allocInfo, &secondary), "vkAllocateCommandBuffers");
+            frame.secondaries.push_back(secondary);
+        }
+    }
+}
+
+void VulkanBackend::Device::recordSecondaries()
+{
+    // Called with the device idle, so nothing recorded here is pending.
+    auto record = [this](std::size_t chunk) {
+        check(vkResetCommandPool(device, recordPools[chunk], 0), "vkResetCommandPool");
+
+        VkCommandBufferInheritanceInfo inheritance {VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
+        inheritance.renderPass = renderPass;
+        inheritance.subpass = 0;
+        VkCommandBufferBeginInfo begin {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+        begin.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        begin.pInheritanceInfo = &inheritance;
+
+        const VkViewport viewport {0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f};
+        const VkRect2D scissor {{0, 0}, extent};
+        const float arena[2] = {static_cast<float>(width), static_cast<float>(height)};
+
+        for (Frame &frame : frames) {
+            VkCommandBuffer commands = frame.secondaries[chunk];
+            check(vkBeginCommandBuffer(commands, &begin), "vkBeginCommandBuffer");
+            vkCmdBindPipeline(commands, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+            vkCmdSetViewport(commands, 0, 1, &viewport);
+            vkCmdSetScissor(commands, 0, 1, &scissor);
+            vkCmdBindDescriptorSets(commands, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+            vkCmdPushConstants(commands, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(arena), arena);
+            const VkDeviceSize offset = instanceOffset + chunk * chunkSize * sizeof(SpriteInstance);
+            vkCmdBindVertexBuffers(commands, 0, 1, &frame.buffer.buffer, &offset);
+            vkCmdDrawIndirect(commands, frame.buffer.buffer, chunk * sizeof(VkDrawIndirectCommand), 1, sizeof(VkDrawIndirectCommand));
+            check(vkEndCommandBuffer(commands), "vkEndCommandBuffer");
+        }
+    };
+
+    pool.run(static_cast<unsigned>(chunks), record);
+}
+
+void VulkanBackend::Device::writeInstances(Frame &frame, const Logos &logos)
+{
+    const std::size_t count = std::min(logos.size(), capacity);
+    auto *commands = static_cast<VkDrawIndirectCommand *>(frame.buffer.mapped);
+    auto *instances = reinterpret_cast<SpriteInstance *>(static_cast<unsigned char *>(frame.buffer.mapped) + instanceOffset);
+
+    auto write = [&](std::size_t chunk) {
+        const std::size_t first = std::min(chunk * chunkSize, count);
+        const std::size_t last = std::min(first + chunkSize, count);
+        for (std::size_t i = first; i < last; i++) {
+            const Variant &variant = variants[logos.id[i] % variants.size()];
+            instances[i] = {logos.x[i], logos.y[i], variant.width * scale, variant.height * scale, variant.u0, variant.v0, variant.u1, variant.v1, variant.layer, 0xffffffff};
+        }
+        commands[chunk].instanceCount = static_cast<std::uint32_t>(last - first);
+    };
+
+    if (count < kMinInstancesPerWrite) {
+        for (std::size_t chunk = 0; chunk < chunks; chunk++)
+            write(chunk);
+    }
+    else
+        pool.run(static_cast<unsigned>(chunks), write);
+}
+
+std::uint32_t VulkanBackend::Device::memoryType(std::uint32_t typeBits, VkMemoryPropertyFlags flags) const
+{
+    for (std::uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+        if ((typeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & flags) == flags)
+            return i;
+    }
+    throw std::runtime_error("No suitable Vulkan memory type");
+}
+
+Buffer VulkanBackend::Device::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage)
+{
+    Buffer buffer;
+    VkBufferCreateInfo info {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+    info.size = size;
+    info.usage = usage;
+    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    check(vkCreateBuffer(device, &info, nullptr, &buffer.buffer), "vkCreateBuffer");
+
+    // Host-visible and coherent, mapped for the buffer's whole life; memory
+    // that is also device local is taken first where there is any.
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(device, buffer.buffer, &requirements);
+    const VkMemoryPropertyFlags hostFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    std::uint32_t type = 0;
+    try {
+        type = memoryType(requirements.memoryTypeBits, hostFlags | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    } catch (const std::runtime_error &) {
+        type = memoryType(requirements.memoryTypeBits, hostFlags);
+    }
+
+    VkMemoryAllocateInfo allocInfo {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    allocInfo.allocationSize = requirements.size;
+    allocInfo.memoryTypeIndex = type;
+    check(vkAllocateMemory(device, &allocInfo, nullptr, &buffer.memory), "vkAllocateMemory");
+    check(vkBindBufferMemory(device, buffer.buffer, buffer.memory, 0), "vkBindBufferMemory");
+    check(vkMapMemory(device, buffer.memory, 0, VK_WHOLE_SIZE, 0, &buffer.mapped), "vkMapMemory");
+    return buffer;
+}
+
+void VulkanBackend::Device::destroyBuffer(Buffer &buffer)
+{
+    vkDestroyBuffer(device, buffer.buffer, nullptr);
+    vkFreeMemory(device, buffer.memory, nullptr);
+    buffer = Buffer();
+}
+
+VkImageView VulkanBackend::Device::createView(VkImage image, VkFormat viewFormat, VkImageViewType type, std::uint32_t levels, std::uint32_t layers)
+{
+    VkImageViewCreateInfo info {VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+    info.image = image;
+    info.viewType = type;
+    info.format = viewFormat;
+    info.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, levels, 0, layers};
+
+    VkImageView view = VK_NULL_HANDLE;
+    check(vkCreateImageView(device, &info, nullptr, &view), "vkCreateImageView");
+    return view;
+}
+
+VkCommandBuffer VulkanBackend::Device::beginOneShot()
+{
+    VkCommandBufferAllocateInfo allocInfo {VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+    allocInfo.commandPool = oneShotPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+    VkCommandBuffer commands = VK_NULL_HANDLE;
+    check(vkAllocateCommandBuffers(device, &allocInfo, &commands), "vkAllocateCommandBuffers");
+
+    VkCommandBufferBeginInfo begin {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    check(vkBeginCommandBuffer(commands, &begin), "vkBeginCommandBuffer");
+    return commands;
+}
+
+void VulkanBackend::Device::endOneShot(VkCommandBuffer commands)
+{
+    check(vkEndCommandBuffer(commands), "vkEndCommandBuffer");
+
+    VkSubmitInfo submit {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+    submit.commandBufferCount = 1;
+    submit.pCommandBuffers = &commands;
+    check(vkQueueSubmit(queue, 1, &submit, VK_NULL_HANDLE), "vkQueueSubmit");
+    check(vkQueueWaitIdle(queue), "vkQueueWaitIdle");
+    vkFreeCommandBuffers(device, oneShotPool, 1, &commands);
+}
+
+VulkanBackend::VulkanBackend() = default;
+
+VulkanBackend::~VulkanBackend() = default;
+
+void VulkanBackend::init(SDL_Window *window, int width, int height, std::size_t capacity, std::uint32_t clearColour, unsigned threads)
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    mDevice = std::make_unique<Device>();
+    Device &vk = *mDevice;
+    vk.width = width;
+    vk.height = height;
+    vk.capacity = std::max<std::size_t>(capacity, 1);
+    vk.threads = threads;
+    vk.clearColour = clearColour;
+    vk.pool.init(threads);
+
+    vk.createInstance(window, mValidate);
+    vk.pickPhysicalDevice();
+    vk.createDevice();
+    vk.createRenderPass();
+    vk.createPipeline();
+    if (window)
+        vk.createSwapchain();
+    else
+        vk.createOffscreen();
+    vk.createFrames();
+}
+
+void VulkanBackend::setValidation(bool validate)
+{
+    mValidate = validate;
+}
+
+std::size_t VulkanBackend::validationErrors() const
+{
+    return mDevice ? mDevice->validationErrors.load() : 0;
+}
+
+void VulkanBackend::setImages(const std::vector<Image> &images)
+{
+    Device &vk = *mDevice;
+    vkDeviceWaitIdle(vk.device);
+
+    // One atlas page per array layer, so every logo shares one descriptor.
+    Atlas atlas = packAtlas(images, std::min(kAtlasMaxPageSize, static_cast<int>(vk.limits.maxImageDimension2D)), kAtlasPadding);
+    if (atlas.pages.size() > vk.limits.maxImageArrayLayers)
+        throw std::runtime_error("Too many atlas pages for a Vulkan image array");
+    for (Image &page : atlas.pages)
+        premultiplyAlpha(page);
+
+    vk.variants.clear();
+    for (const AtlasEntry &entry : atlas.entries)
+        vk.variants.push_back({static_cast<float>(entry.width), static_cast<float>(entry.height), static_cast<float>(entry.page), entry.u0, entry.v0, entry.u1, entry.v1});
+
+    const std::size_t levels = static_cast<std::size_t>(atlasMipLevels(atlas));
+    std::vector<std::vector<Image>> chains;
+    VkDeviceSize stagingSize = 0;
+    for (const Image &page : atlas.pages) {
+        chains.push_back(buildMipChain(page, static_cast<int>(levels)));
+        for (const Image &level : chains.back())
+            stagingSize += level.pixels.size();
+    }
+
+    vkDestroyImageView(vk.device, vk.atlasView, nullptr);
+    vkDestroyImage(vk.device, vk.atlas, nullptr);
+    vkFreeMemory(vk.device, vk.atlasMemory, nullptr);
+
+    VkImageCreateInfo imageInfo {VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+    imageInfo.extent = {static_cast<std::uint32_t>(atlas.pageSize), static_cast<std::uint32_t>(atlas.pageSize), 1};
+    imageInfo.mipLevels = static_cast<std::uint32_t>(levels);
+    imageInfo.arrayLayers = static_cast<std::uint32_t>(atlas.pages.size());
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    check(vkCreateImage(vk.device, &imageInfo, nullptr, &vk.atlas), "vkCreateImage");
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(vk.device, vk.atlas, &requirements);
+    VkMemoryAllocateInfo allocInfo {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    allocInfo.allocationSize = requirements.size;
+    allocInfo.memoryTypeIndex = vk.memoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    check(vkAllocateMemory(vk.device, &allocInfo, nullptr, &vk.atlasMemory), "vkAllocateMemory");
+    check(vkBindImageMemory(vk.device, vk.atlas, vk.atlasMemory, 0), "vkBindImageMemory");
+
+    Buffer staging = vk.createBuffer(stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+    std::vector<VkBufferImageCopy> regions;
+    VkDeviceSize offset = 0;
+    for (std::size_t page = 0; page < chains.size(); page++) {
+        for (std::size_t level = 0; level < levels; level++) {
+            const Image &image = chains[page][level];
+            std::memcpy(static_cast<unsigned char *>(staging.mapped) + offset, image.pixels.data(), image.pixels.size());
+
+            VkBufferImageCopy region {};
+            region.bufferOffset = offset;
+            region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, static_cast<std::uint32_t>(level), static_cast<std::uint32_t>(page), 1};
+            region.imageExtent = {static_cast<std::uint32_t>(image.width), static_cast<std::uint32_t>(image.height), 1};
+            regions.push_back(region);
+            offset += image.pixels.size();
+        }
+    }
+
+    VkImageMemoryBarrier barrier {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = vk.atlas;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, imageInfo.mipLevels, 0, imageInfo.arrayLayers};
+
+    VkCommandBuffer commands = vk.beginOneShot();
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(commands, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    vkCmdCopyBufferToImage(commands, staging.buffer, vk.atlas, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<std::uint32_t>(regions.size()), regions.data());
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(commands, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    vk.endOneShot(commands);
+    vk.destroyBuffer(staging);
+
+    vk.atlasView = vk.createView(vk.atlas, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_VIEW_TYPE_2D_ARRAY, imageInfo.mipLevels, imageInfo.arrayLayers);
+
+    VkDescriptorImageInfo descriptorImage {vk.sampler, vk.atlasView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    VkWriteDescriptorSet write {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+    write.dstSet = vk.descriptorSet;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &descriptorImage;
+    vkUpdateDescriptorSets(vk.device, 1, &write, 0, nullptr);
+
+    // Updating the set invalidated anything that bound it.
+    vk.recordSecondaries();
+}
+
+void VulkanBackend::setScale(float scale)
+{
+    mDevice->scale = scale;
+}
+
+void VulkanBackend::drawFrame(const Logos &logos, FrameStats &stats)
+{
+    using Clock = std::chrono::steady_clock;
+
+    Device &vk = *mDevice;
+    Frame &frame = vk.frames[vk.frameIndex];
+
+    auto waitStart = Clock::now();
+    if (vkGetFenceStatus(vk.device, frame.fence) == VK_NOT_READY) {
+        check(vkWaitForFences(vk.device, 1, &frame.fence, VK_TRUE, UINT64_MAX), "vkWaitForFences");
+        stats.fenceStalls++;
+        stats.fenceStallMs += std::chrono::duration<double, std::milli>(Clock::now() - waitStart).count();
+    }
+
+    auto submitStart = Clock::now();
+    vk.writeInstances(frame, logos);
+
+    // A minimized window has no swapchain; keep simulating, skip drawing.
+    if (vk.window && !vk.swapchain) {
+        vkDeviceWaitIdle(vk.device);
+        if (!vk.createSwapchain())
+            return;
+        vk.recordSecondaries();
+    }
+
+    std::uint32_t imageIndex = 0;
+    if (vk.swapchain) {
+        const VkResult result = vkAcquireNextImageKHR(vk.device, vk.swapchain, UINT64_MAX, frame.imageAvailable, VK_NULL_HANDLE, &imageIndex);
+        if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            vkDeviceWaitIdle(vk.device);
+            if (vk.createSwapchain())
+                vk.recordSecondaries();
+            return;
+        }
+        if (result != VK_SUBOPTIMAL_KHR)
+            check(result, "vkAcquireNextImageKHR");
+    }
+    const Target &target = vk.targets[imageIndex];
+
+    check(vkResetFences(vk.device, 1, &frame.fence), "vkResetFences");
+    check(vkResetCommandBuffer(frame.primary, 0), "vkResetCommandBuffer");
+    VkCommandBufferBeginInfo begin {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    check(vkBeginCommandBuffer(frame.primary, &begin), "vkBeginCommandBuffer");
+
+    VkClearValue clear {};
+    for (int c = 0; c < 4; c++)
+        clear.color.float32[c] = static_cast<float>((vk.clearColour >> (c * 8)) & 0xff) / 255.0f;
+    VkRenderPassBeginInfo passInfo {VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
+    passInfo.renderPass = vk.renderPass;
+    passInfo.framebuffer = target.framebuffer;
+    passInfo.renderArea = {{0, 0}, vk.extent};
+    passInfo.clearValueCount = 1;
+    passInfo.pClearValues = &clear;
+    vkCmdBeginRenderPass(frame.primary, &passInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    vkCmdExecuteCommands(frame.primary, static_cast<std::uint32_t>(frame.secondaries.size()), frame.secondaries.data());
+    vkCmdEndRenderPass(frame.primary);
+    check(vkEndCommandBuffer(frame.primary), "vkEndCommandBuffer");
+
+    const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    VkSubmitInfo submit {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+    if (vk.swapchain) {
+        submit.waitSemaphoreCount = 1;
+        submit.pWaitSemaphores = &frame.imageAvailable;
+        submit.pWaitDstStageMask = &waitStage;
+        submit.signalSemaphoreCount = 1;
+        submit.pSignalSemaphores = &target.renderFinished;
+    }
+    submit.commandBufferCount = 1;
+    submit.pCommandBuffers = &frame.primary;
+    check(vkQueueSubmit(vk.queue, 1, &submit, frame.fence), "vkQueueSubmit");
+
+    stats.submitMs = std::chrono::duration<double, std::milli>(Clock::now() - submitStart).count();
+    stats.drawCalls += frame.secondaries.size();
+    stats.instances += std::min(logos.size(), vk.capacity);
+    stats.redrawnPixels = static_cast<std::size_t>(vk.extent.width) * vk.extent.height;
+    vk.frameIndex = (vk.frameIndex + 1) % kFramesInFlight;
+
+    if (vk.swapchain) {
+        VkPresentInfoKHR present {VK_STRUCTURE_TYPE_PRESENT_INFO_KHR};
+        present.waitSemaphoreCount = 1;
+        present.pWaitSemaphores = &target.renderFinished;
+        present.swapchainCount = 1;
+        present.pSwapchains = &vk.swapchain;
+        present.pImageIndices = &imageIndex;
+        const VkResult result = vkQueuePresentKHR(vk.queue, &present);
+        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+            vkDeviceWaitIdle(vk.device);
+            if (vk.createSwapchain())
+                vk.recordSecondaries();
+        }
+        else
+            check(result, "vkQueuePresentKHR");
+    }
+}
+
+Image VulkanBackend::capture()
+{
+    Device &vk = *mDevice;
+    if (vk.swapchain)
+        throw std::runtime_error("Vulkan screenshots need --headless");
+
+    Image image;
+    image.width = static_cast<int>(vk.extent.width);
+    image.height = static_cast<int>(vk.extent.height);
+    image.pixels.resize(static_cast<std::size_t>(image.width) * image.height * 4);
+
+    // The render pass left the image in TRANSFER_SRC_OPTIMAL, made visible
+    // to transfers; only the host read needs a barrier.
+    Buffer readback = vk.createBuffer(image.pixels.size(), VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+    VkCommandBuffer commands = vk.beginOneShot();
+    VkBufferImageCopy region {};
+    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.imageExtent = {vk.extent.width, vk.extent.height, 1};
+    vkCmdCopyImageToBuffer(commands, vk.targets.front().image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback.buffer, 1, &region);
+
+    VkBufferMemoryBarrier barrier {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = readback.buffer;
+    barrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(commands, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+    vk.endOneShot(commands);
+
+    std::memcpy(image.pixels.data(), readback.mapped, image.pixels.size());
+    vk.destroyBuffer(readback);
+    return image;
+}
+
+#else
+
+struct VulkanBackend::Device {
+};
+
+VulkanBackend::VulkanBackend() = default;
+
+VulkanBackend::~VulkanBackend() = default;
+
+void VulkanBackend::init(SDL_Window *, int, int, std::size_t, std::uint32_t, unsigned)
+{
+    throw std::runtime_error("Built without Vulkan; configure with -DDVD_VULKAN=ON");
+}
+
+void VulkanBackend::setValidation(bool validate)
+{
+    mValidate = validate;
+}
+
+std::size_t VulkanBackend::validationErrors() const
+{
+    return 0;
+}
+
+void VulkanBackend::setImages(const std::vector<Image> &)
+{
+}
+
+void VulkanBackend::setScale(float)
+{
+}
+
+void VulkanBackend::drawFrame(const Logos &, FrameStats &)
+{
+}
+
+Image VulkanBackend::capture()
+{
+    return {};
+}
+
+#endif
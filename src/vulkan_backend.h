@@ -0,0 +1,65 @@
+#ifndef VULKAN_BACKEND_H
+#define VULKAN_BACKEND_H
+
+#include "logo_backend.h"
+
+#include <cstdint>
+#include <memory>
+
+struct SDL_Window;
+
+/*
+ * Instanced logos through Vulkan. Logos are packed into an atlas uploaded as
+ * one array layer per page, so every logo is one instance of a single draw.
+ *
+ * kFramesInFlight frames each own a persistently mapped, host-visible
+ * instance buffer, a fence and a primary command buffer. The draws are
+ * split into one chunk per thread, and each chunk's secondary command
+ * buffer is recorded once per frame slot at init, by a worker pool with one
+ * command pool per chunk. They only ever read their slot's instance buffer,
+ * so a frame just waits on its fence, writes instances, and re-records a
+ * primary that runs the secondaries inside the render pass.
+ *
+ * Needs only Vulkan 1.0, so CPU drivers work too; dvd-vulkan-check renders
+ * offscreen on lavapipe under the Khronos validation layer and compares
+ * the result with the GL renderer. With no window it renders into an
+ * offscreen image that capture() reads back. Only built with
+ * -DDVD_VULKAN=ON; init() throws otherwise.
+ */
+class VulkanBackend : public LogoBackend {
+public:
+    static constexpr std::uint32_t kFramesInFlight {3};
+
+    VulkanBackend();
+    ~VulkanBackend() override;
+
+    /*
+     * Before init(): enables VK_LAYER_KHRONOS_validation, which init() then
+     * throws without. Its warnings and errors go to stderr.
+     */
+    void setValidation(bool validate);
+    /* Validation errors reported so far. */
+    std::size_t validationErrors() const;
+
+    /*
+     * window must have been created with SDL_WINDOW_VULKAN, or be null for
+     * offscreen rendering. capacity bounds the logos per frame; threads 0
+     * uses every hardware thread. clearColour is RGBA8, red in the lowest
+     * byte.
+     */
+    void init(SDL_Window *window, int width, int height, std::size_t capacity, std::uint32_t clearColour, unsigned threads = 0);
+
+    void setImages(const std::vector<Image> &images) override;
+    void setScale(float scale) override;
+    void drawFrame(const Logos &logos, FrameStats &stats) override;
+    /* Offscreen only; swapchain images are gone once presented. */
+    Image capture() override;
+
+private:
+    struct Device;
+
+    std::unique_ptr<Device> mDevice;
+    bool mValidate {false};
+};
+
+#endif    // VULKAN_BACKEND_H
@@ -0,0 +1,60 @@
+#include "golden.h"
+#include "headless.h"
+#include "vulkan_backend.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+/*
+ * Renders the golden scene offscreen with VulkanBackend and compares it with
+ * the GL instanced renderer on a headless context. The validation layer is
+ * on unless the second argument is 0, and any error it reports fails the
+ * check. Run from the build directory, where the assets and the SPIR-V
+ * shaders sit side by side; exits non-zero on a mismatch.
+ *
+ * Usage: dvd-vulkan-check [logos] [validate]
+ */
+
+// Enough frames to cycle every frame in flight's buffers and commands.
+static constexpr int kFrames {VulkanBackend::kFramesInFlight * 2};
+// Drivers round filtering and blending differently by a few steps; a wrong
+// image, uv or blend is off by far more.
+static constexpr int kTolerance {16};
+
+int main(int argc, char **argv)
+{
+    try {
+        const std::size_t count = argc > 1 ? std::stoul(argv[1]) : 2000;
+        const bool validate = argc > 2 ? std::stoi(argv[2]) != 0 : true;
+
+        const GoldenScene scene = goldenScene(count);
+
+        HeadlessContext context;
+        context.init(kGoldenWidth, kGoldenHeight);
+        const Image reference = renderGolden(scene);
+        context.destroy();
+
+        VulkanBackend vulkan;
+        vulkan.setValidation(validate);
+        vulkan.init(nullptr, kGoldenWidth, kGoldenHeight, count, kGoldenClearColour);
+        vulkan.setImages(scene.images);
+        vulkan.setScale(kGoldenScale);
+        FrameStats stats;
+        for (int frame = 0; frame < kFrames; frame++)
+            vulkan.drawFrame(scene.logos, stats);
+        const Image image = vulkan.capture();
+
+        const int difference = maxChannelDifference(reference, image);
+        const std::size_t errors = vulkan.validationErrors();
+        std::cout << count << " logos: max channel difference " << difference << " (tolerance " << kTolerance << "), "
+                  << (validate ? std::to_string(errors) + " validation errors" : "validation off") << std::endl;
+        return difference <= kTolerance && errors == 0 ? 0 : 1;
+    } catch (const std::logic_error &) {
+        std::cerr << "Usage: dvd-vulkan-check [logos] [validate]" << std::endl;
+        return 1;
+    } catch (const std::runtime_error &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
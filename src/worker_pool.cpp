@@ -0,0 +1,100 @@
+#include "worker_pool.h"
+
+#include <algorithm>
+
+WorkerPool::~WorkerPool()
+{
+    destroy();
+}
+
+void WorkerPool::init(unsigned threads)
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    if (threads == this->threads())
+        return;
+
+    destroy();
+    mStopping = false;
+    mThreads = threads;
+    for (unsigned t = 1; t < threads; t++)
+        mWorkers.emplace_back(&WorkerPool::workerLoop, this, t);
+}
+
+void WorkerPool::destroy()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mWake.notify_all();
+    for (std::thread &worker : mWorkers)
+        worker.join();
+    mWorkers.clear();
+    mThreads = 1;
+    mGeneration = 0;
+}
+
+unsigned WorkerPool::threads() const
+{
+    return mThreads;
+}
+
+void WorkerPool::run(unsigned count, const std::function<void(unsigned)> &fn)
+{
+    const unsigned stride = threads();
+    if (count <= 1 || stride == 1) {
+        for (unsigned t = 0; t < count; t++)
+            fn(t);
+        return;
+    }
+
+    // Only the workers that have a task are woken up and waited for.
+    const unsigned helpers = std::min(count, stride) - 1;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mJob = &fn;
+        mJobCount = count;
+        mRunning = helpers;
+        mGeneration++;
+    }
+    mWake.notify_all();
+
+    for (unsigned t = 0; t < count; t += stride)
+        fn(t);
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDone.wait(lock, [&]() { return mRunning == 0; });
+    mJob = nullptr;
+}
+
+void WorkerPool::workerLoop(unsigned index)
+{
+    std::uint64_t seen = 0;
+    for (;;) {
+        const std::function<void(unsigned)> *job;
+        unsigned count;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWake.wait(lock, [&]() { return mStopping || mGeneration != seen; });
+            if (mStopping)
+                return;
+            seen = mGeneration;
+            job = mJob;
+            count = mJobCount;
+        }
+        if (index >= count)
+            continue;
+
+        for (unsigned t = index; t < count; t += mThreads)
+            (*job)(t);
+
+        bool last;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            last = --mRunning == 0;
+        }
+        if (last)
+            mDone.notify_one();
+    }
+}
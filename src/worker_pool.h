@@ -0,0 +1,49 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Threads that live as long as the pool and sleep between jobs, so per-frame
+ * and per-pass work does not pay for creating and joining threads. The
+ * calling thread takes part in every job as worker 0.
+ */
+class WorkerPool {
+public:
+    WorkerPool() = default;
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+    ~WorkerPool();
+
+    /* threads 0 uses every hardware thread; the caller counts as one. */
+    void init(unsigned threads = 0);
+    void destroy();
+
+    unsigned threads() const;
+
+    /* Calls fn(t) for every t below count, at most threads() at a time, and returns once all are done. */
+    void run(unsigned count, const std::function<void(unsigned)> &fn);
+
+private:
+    void workerLoop(unsigned index);
+
+    unsigned mThreads {1};
+    std::vector<std::thread> mWorkers;
+    std::mutex mMutex;
+    std::condition_variable mWake;
+    std::condition_variable mDone;
+    const std::function<void(unsigned)> *mJob {nullptr};
+    unsigned mJobCount {0};
+    /* Bumped per job, so a sleeping worker can tell a new job from a spurious wake. */
+    std::uint64_t mGeneration {0};
+    unsigned mRunning {0};
+    bool mStopping {false};
+};
+
+#endif    // WORKER_POOL_H